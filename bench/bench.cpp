@@ -0,0 +1,132 @@
+#include "bench.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+using namespace std;
+
+volatile size_t bench::sink = 0;
+
+vector<bench*>&
+bench::all()
+{
+   static vector<bench*> benches;
+
+   return benches;
+}
+
+bench::bench(const char* nm, const char* abt, function<void()> fn)
+   : name (nm)
+   , about (abt)
+   , run (fn)
+{
+   all().push_back(this);
+}
+
+int
+bench::main(int argc, char** argv)
+{
+   if ((argc == 2) && (strcmp(argv[1], "--list") == 0))
+   {
+      for (bench* b : all())
+	 cout << b->name << endl;
+
+      return 0;
+   }
+
+   vector<bench*> chosen;
+
+   for (int i = 1; i < argc; ++i)
+   {
+      bench* found = nullptr;
+
+      for (bench* b : all())
+      {
+	 if (strcmp(b->name, argv[i]) == 0)
+	    found = b;
+      }
+
+      if (!found)
+      {
+	 cerr << "No bench '" << argv[i] << "'; --list lists them." << endl;
+
+	 return 1;
+      }
+
+      chosen.push_back(found);
+   }
+
+   if (chosen.empty())
+      chosen = all();
+
+   for (bench* b : chosen)
+   {
+      cout << b->name << ": " << b->about << endl;
+
+      b->run();
+
+      cout << endl;
+   }
+
+   return 0;
+}
+
+double
+bench::best_of(unsigned reps, const function<void()>& fn)
+{
+   double best = 0;
+
+   for (unsigned i = 0; i < reps; ++i)
+   {
+      chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+      fn();
+
+      double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+      if (!i || (secs < best))
+	 best = secs;
+   }
+
+   return best;
+}
+
+void
+bench::report(const string& what, double value, const string& unit)
+{
+   cout << "   " << left << setw(40) << what << " " <<
+      fixed << setprecision((value < 10) ? 2 : (value < 100) ? 1 : 0) << value << " " << unit << endl;
+}
+
+void
+bench::report_rate(const string& what, size_t bytes, double secs)
+{
+   double rate = bytes / secs / 1e6;
+
+   if (rate >= 1000)
+      report(what, rate / 1000, "GB/s");
+
+   else report(what, rate, "MB/s");
+}
+
+void
+bench::report_time(const string& what, double secs)
+{
+   if (secs < 1)
+      report(what, secs * 1000, "ms");
+
+   else report(what, secs, "s");
+}
+
+void
+bench::note(const string& what)
+{
+   cout << "   " << what << endl;
+}
+
+int main(int argc, char** argv)
+{
+   return bench::main(argc, argv);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+class bench
+/*
+  A benchmark, for measuring again something that's been made faster.
+  `make bench` builds them all into adze-bench and runs each in a
+  process of its own (so that one's memory doesn't count against the
+  next); `./adze-bench <name>...` runs just those, and
+  `./adze-bench --list` lists them.
+
+  Each file here adds its own, at file scope:
+
+  static bench lexing("lex", "Lexing a generated source", [] { ... });
+
+  Inputs are generated (see sources.cpp) rather than checked in, and
+  are the same every time, so numbers from one checkout can be held
+  up against another's on the same machine.
+*/
+{
+private:
+   const char* name;
+   const char* about;
+   std::function<void()> run;
+
+   static std::vector<bench*>& all();
+
+public:
+   bench(const char* nm, const char* abt, std::function<void()> fn);
+
+   //Run those named in argv, or all of them if none are; 1 if one of
+   //them isn't a bench
+   static int main(int argc, char** argv);
+
+   //Seconds taken by the fastest of 'reps' calls of fn
+   static double best_of(unsigned reps, const std::function<void()>& fn);
+
+   //A line of results: what was measured, and how it came out
+   static void report(const std::string& what, double value, const std::string& unit);
+   //'bytes' done in 'secs', as MB/s (or GB/s)
+   static void report_rate(const std::string& what, size_t bytes, double secs);
+   static void report_time(const std::string& what, double secs);
+   //A line of anything else
+   static void note(const std::string& what);
+
+   //Somewhere to put results that mustn't be optimised away
+   static volatile size_t sink;
+};
+
+//Generated inputs; see sources.cpp
+
+//n functions, each with a comment banner, a couple of locals, some
+//arithmetic and a call to the one before: 20000 make 9.6MB
+std::string functions_source(unsigned n);
+//Lines of keywords, types and short names, with a few operators and
+//literals between them, to about 'bytes' long: 12.9MB is 3M tokens
+std::string names_source(size_t bytes);
+//n functions of int arithmetic on literals and locals, with x * 1 + 0
+//and x * 2^k in them, for --fold to fold
+std::string literals_source(unsigned n);
@@ -0,0 +1,64 @@
+#include "bench.hpp"
+
+#include "../src/Parser.hpp"
+
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/SourceMgr.h"
+
+using namespace std;
+
+//Writing the generated source's module as text IR and as bitcode, and
+//how long each takes to read back in, as whatever's downstream would
+static bench emitting("emit", "Writing text IR against bitcode, and reading them back", []
+{
+   string source = functions_source(20000);
+
+   Parser prs;
+   lexer lx(&prs.GetNames());
+
+   lx.open(source.data(), source.size());
+
+   prs.Parse(lx);
+   prs.Generate();
+
+   for (bool bitcode : {false, true})
+   {
+      const char* kind = bitcode ? "bitcode" : "text IR";
+
+      llvm::SmallString<128> path;
+
+      if (llvm::sys::fs::createTemporaryFile("adze-bench", bitcode ? "bc" : "ll", path))
+      {
+	 bench::note("Couldn't make a file to write");
+
+	 return;
+      }
+
+      bench::report_time(string("writing ") + kind, bench::best_of(3, [&]
+      {
+	 prs.EmitIR(path.str().str(), bitcode);
+      }));
+
+      uint64_t size = 0;
+
+      llvm::sys::fs::file_size(path, size);
+
+      bench::report(string("size of ") + kind, size / 1e6, "MB");
+
+      bool read = true;
+
+      bench::report_time(string("reading ") + kind + " back", bench::best_of(3, [&]
+      {
+	 llvm::LLVMContext context;
+	 llvm::SMDiagnostic err;
+
+	 read &= (bool) llvm::parseIRFile(path, err, context);
+      }));
+
+      if (!read)
+	 bench::note(string("Couldn't read the ") + kind + " back");
+
+      llvm::sys::fs::remove(path);
+   }
+});
@@ -0,0 +1,69 @@
+#include "bench.hpp"
+
+#include "../src/Parser.hpp"
+
+#include "llvm/Support/FileSystem.h"
+
+#include <sstream>
+
+using namespace std;
+
+//Compiling functions full of literals to an object at -O0, with and
+//without --fold, and with and without --ssa: the tree's size, the
+//module's, and the time from the parsed tree to the object
+static bench folding("fold", "Folding constants in the parsed tree", []
+{
+   string source = literals_source(5000);
+
+   llvm::SmallString<128> path;
+
+   if (llvm::sys::fs::createTemporaryFile("adze-bench", "o", path))
+   {
+      bench::note("Couldn't make a file to write");
+
+      return;
+   }
+
+   for (bool ssa : {false, true})
+   {
+      for (bool fold : {false, true})
+      {
+	 string how = string(fold ? "folded" : "unfolded") + (ssa ? ", --ssa" : "");
+
+	 Parser prs;
+	 lexer lx(&prs.GetNames());
+
+	 lx.open(source.data(), source.size());
+
+	 prs.Parse(lx);
+	 prs.SetSSA(ssa);
+
+	 //What's printed is the stats, to report as they come
+	 ostringstream stats;
+	 streambuf* old = cout.rdbuf(stats.rdbuf());
+
+	 double secs = bench::best_of(1, [&]
+	 {
+	    if (fold)
+	       prs.Fold(true);
+
+	    prs.Generate();
+	    prs.SetTarget("", 0);
+	    prs.Emit(path.str().str(), false, nullptr);
+	 });
+
+	 prs.PrintStats("Generated");
+
+	 cout.rdbuf(old);
+
+	 istringstream lines(stats.str());
+
+	 for (string line; getline(lines, line);)
+	    bench::note(how + ": " + line);
+
+	 bench::report_time(how + ", to an object at -O0", secs);
+      }
+   }
+
+   llvm::sys::fs::remove(path);
+});
@@ -0,0 +1,117 @@
+#include "bench.hpp"
+
+#include "../src/lexer.hpp"
+
+#include "llvm/Support/FileSystem.h"
+
+#include <fstream>
+#include <map>
+
+using namespace std;
+
+//Lexing a file, against just reading it a character at a time from an
+//ifstream, as the lexer did before it mapped the file
+static bench lexing("lex", "Lexing the generated 9.6MB source from a file", []
+{
+   string source = functions_source(20000);
+
+   llvm::SmallString<128> path;
+
+   if (llvm::sys::fs::createTemporaryFile("adze-bench", "adze", path))
+   {
+      bench::note("Couldn't make a file to lex");
+
+      return;
+   }
+
+   ofstream(path.c_str(), ios::binary).write(source.data(), source.size());
+
+   bench::report_time("reading it a char at a time", bench::best_of(5, [&]
+   {
+      ifstream in(path.c_str());
+      size_t n = 0;
+
+      while (in.get() != char_traits<char>::eof())
+	 ++n;
+
+      bench::sink += n;
+   }));
+
+   size_t tokens = 0;
+
+   double secs = bench::best_of(5, [&]
+   {
+      lexer lx;
+
+      tokens = lx.lex(const_cast<char*>(path.c_str())).size();
+   });
+
+   bench::report_time("lexing it", secs);
+   bench::report_rate("throughput", source.size(), secs);
+   bench::report("tokens", tokens / 1e3, "k");
+
+   llvm::sys::fs::remove(path);
+});
+
+//Lexing lots of short words, most of them keywords or types; and just
+//looking each one up, in the keyword hash (see lexer.hpp) against the
+//std::maps it replaced
+static bench keywordLookup("keywords", "Lexing and looking up keywords and names", []
+{
+   string source = names_source(12900000);
+
+   size_t tokens = 0;
+
+   double secs = bench::best_of(5, [&]
+   {
+      lexer lx;
+
+      tokens = lx.lex(source.data(), source.size()).size();
+   });
+
+   bench::report_time("lexing 12.9MB", secs);
+   bench::report("tokens", tokens / 1e6, "M");
+   bench::report("tokens lexed", tokens / secs / 1e6, "M/s");
+
+   llvm::SmallVector<llvm::StringRef, 0> words;
+
+   llvm::StringRef(source).split(words, ' ', -1, false);
+
+   map<string, token_kind> keywordMap;
+
+   for (const keyword& kw : keywords)
+      keywordMap[kw.name] = kw.kind;
+
+   for (const keyword& kw : primitives)
+      keywordMap[kw.name] = kw.kind;
+
+   bench::report("looked up in the keyword hash", words.size() / 1e6 / bench::best_of(5, [&]
+   {
+      size_t found = 0;
+
+      for (llvm::StringRef w : words)
+      {
+	 int i = keyword_lookup.slots[keyword_hash(w.data(), w.size())];
+
+	 if (i < 0)
+	    continue;
+
+	 const keyword& kw = (i < (int) llvm::array_lengthof(keywords)) ?
+	    keywords[i] : primitives[i - llvm::array_lengthof(keywords)];
+
+	 found += (w.size() == kw.len) && !memcmp(w.data(), kw.name, kw.len);
+      }
+
+      bench::sink += found;
+   }), "M/s");
+
+   bench::report("looked up in a std::map", words.size() / 1e6 / bench::best_of(5, [&]
+   {
+      size_t found = 0;
+
+      for (llvm::StringRef w : words)
+	 found += keywordMap.count(w.str());
+
+      bench::sink += found;
+   }), "M/s");
+});
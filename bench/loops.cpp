@@ -0,0 +1,107 @@
+#include "bench.hpp"
+
+#include "../src/Parser.hpp"
+
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+#include <regex>
+#include <sstream>
+
+using namespace std;
+
+//examples/kernels.adze's dot product, 400M times round
+static const char* dot =
+   "float dot(float a, int n)\n"
+   "{\n"
+   "\tfloat s = 0.0;\n"
+   "\n"
+   "\tfor int i = 0; i < n; i = i + 1 {\n"
+   "\t\tfloat x = i * a;\n"
+   "\t\tfloat y = i + 1;\n"
+   "\n"
+   "\t\ts = s + x * y;\n"
+   "\t}\n"
+   "\n"
+   "\treturn s;\n"
+   "}\n"
+   "\n"
+   "float main()\n"
+   "{\n"
+   "\treturn dot(0.000001, 400000000);\n"
+   "}\n";
+
+//Parsed, generated and optimised at -O3 for the JIT, as --run would
+static void
+compile(Parser& prs, bool fastMath)
+{
+   lexer lx(&prs.GetNames());
+
+   lx.open(dot, strlen(dot));
+
+   prs.SetSSA(true);
+   prs.SetFastMath(fastMath);
+
+   prs.Parse(lx);
+   prs.Generate();
+   prs.SetJITTarget();
+   prs.Optimise(3, false);
+}
+
+//A float reduction in a counted loop, with and without --fast-math
+//(which lets it be vectorised): how wide it's vectorised, and the
+//time to JIT and run it
+static bench loops("loops", "A dot product loop, vectorised or not", []
+{
+   llvm::SmallString<128> path;
+
+   if (llvm::sys::fs::createTemporaryFile("adze-bench", "ll", path))
+   {
+      bench::note("Couldn't make a file to write");
+
+      return;
+   }
+
+   for (bool fastMath : {false, true})
+   {
+      string how = fastMath ? "--fast-math" : "exact";
+
+      //The widest float vector in its IR, if any
+      {
+	 Parser prs;
+
+	 compile(prs, fastMath);
+	 prs.EmitIR(path.str().str(), false);
+      }
+
+      llvm::ErrorOr<unique_ptr<llvm::MemoryBuffer>> ir = llvm::MemoryBuffer::getFile(path);
+
+      unsigned widest = 0;
+
+      if (ir)
+      {
+	 string text = (*ir)->getBuffer().str();
+	 regex vec("<([0-9]+) x float>");
+
+	 for (sregex_iterator m(text.begin(), text.end(), vec); m != sregex_iterator(); ++m)
+	    widest = max(widest, (unsigned) stoul((*m)[1]));
+      }
+
+      bench::note(how + ": " + (widest ? "<" + to_string(widest) + " x float>" : "not vectorised"));
+
+      Parser prs;
+
+      compile(prs, fastMath);
+
+      ostringstream out;
+      streambuf* old = cout.rdbuf(out.rdbuf());
+
+      double secs = bench::best_of(1, [&] { prs.Run("main", nullptr); });
+
+      cout.rdbuf(old);
+
+      bench::report_time(how + ", JITted and run", secs);
+   }
+
+   llvm::sys::fs::remove(path);
+});
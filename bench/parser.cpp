@@ -0,0 +1,191 @@
+#include "bench.hpp"
+
+#include "../src/Parser.hpp"
+
+#include "llvm/Support/ErrorHandling.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <map>
+
+#include <sys/resource.h>
+
+using namespace std;
+
+//Every operator new in the process is counted here, for seeing how
+//many the parser makes
+static atomic<size_t> news(0);
+
+void* operator new(size_t size)
+{
+   ++news;
+
+   void* p = malloc(size ? size : 1);
+
+   if (!p)
+      llvm::report_bad_alloc_error("bench: out of memory");
+
+   return p;
+}
+
+void* operator new[](size_t size)
+{
+   return operator new(size);
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+//Peak memory of this process so far, in MB (so of this bench, run on
+//its own)
+static double
+peak_rss()
+{
+   struct rusage usage;
+
+   getrusage(RUSAGE_SELF, &usage);
+
+   return usage.ru_maxrss / 1024.0;
+}
+
+//Compiling the generated source to a module, as main() does, and
+//looking its names up by symbol against by string, as ParseScope did
+//before they were interned
+static bench interning("intern", "Interned names, through a whole compile", []
+{
+   string source = functions_source(20000);
+
+   double secs = bench::best_of(1, [&]
+   {
+      Parser prs;
+      lexer lx(&prs.GetNames());
+
+      lx.open(source.data(), source.size());
+
+      prs.Parse(lx);
+      prs.Generate();
+   });
+
+   bench::report_time("lexing, parsing and generating 9.6MB", secs);
+   bench::report("peak memory", peak_rss(), "MB");
+
+   Interner names;
+   lexer lx(&names);
+
+   token_string toks = lx.lex(source.data(), source.size());
+
+   vector<token> named;
+
+   for (size_t i = 0; i < toks.size(); ++i)
+   {
+      if (toks[i].GetKind() == token_kind::NAME)
+	 named.push_back(toks[i]);
+   }
+
+   bench::report("names", named.size() / 1e3, "k");
+   bench::report("distinct names", names.size() / 1e3, "k");
+
+   vector<int> bySymbol(names.size(), 1);
+   map<string, int> byString;
+
+   for (const token& tok : named)
+      byString[tok.GetValue().str()] = 1;
+
+   bench::report("looked up by symbol", named.size() / 1e6 / bench::best_of(5, [&]
+   {
+      size_t found = 0;
+
+      for (const token& tok : named)
+	 found += bySymbol[tok.GetSymbol()];
+
+      bench::sink += found;
+   }), "M/s");
+
+   bench::report("looked up by string", named.size() / 1e6 / bench::best_of(5, [&]
+   {
+      size_t found = 0;
+
+      for (const token& tok : named)
+	 found += byString[tok.GetValue().str()];
+
+      bench::sink += found;
+   }), "M/s");
+});
+
+//Just parsing (and the lexing it pulls tokens from), which allocates
+//the tree from the Parser's arena rather than node by node
+static bench arena("arena", "Parsing into the arena", []
+{
+   string source = functions_source(20000);
+
+   size_t allocations = 0;
+
+   double secs = bench::best_of(5, [&]
+   {
+      Parser prs;
+      lexer lx(&prs.GetNames());
+
+      lx.open(source.data(), source.size());
+
+      size_t before = news;
+
+      prs.Parse(lx);
+
+      allocations = news - before;
+   });
+
+   bench::report_time("lexing and parsing 9.6MB", secs);
+   bench::report("operator new calls in that", allocations, "");
+});
+
+//Generating from the Expression tree, against flattening it and
+//generating from the FlatTree. Each is parsed again first, untimed
+static bench flatTree("flat", "Generating from the tree and from a FlatTree", []
+{
+   string source = functions_source(20000);
+
+   double tree = 0;
+   double flatten = 0;
+   double flat = 0;
+
+   for (int rep = 0; rep < 3; ++rep)
+   {
+      for (bool flattened : {false, true})
+      {
+	 Parser prs;
+	 lexer lx(&prs.GetNames());
+
+	 lx.open(source.data(), source.size());
+
+	 prs.Parse(lx);
+
+	 bool ok = true;
+	 double f = flattened ? bench::best_of(1, [&] { ok = prs.Flatten(); }) : 0;
+
+	 if (!ok)
+	 {
+	    bench::note("Couldn't flatten it");
+
+	    return;
+	 }
+
+	 double g = bench::best_of(1, [&] { prs.Generate(); });
+
+	 double& best = flattened ? flat : tree;
+
+	 if (!rep || (g < best))
+	 {
+	    best = g;
+
+	    if (flattened)
+	       flatten = f;
+	 }
+      }
+   }
+
+   bench::report_time("generating 20k functions from the tree", tree);
+   bench::report_time("flattening them", flatten);
+   bench::report_time("generating them from the FlatTree", flat);
+});
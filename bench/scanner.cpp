@@ -0,0 +1,77 @@
+#include "bench.hpp"
+
+#include "../src/scanner.hpp"
+#include "../src/lexer.hpp"
+
+using namespace std;
+
+//Each kernel over 1MB it goes all the way through, then lexing as a
+//whole, for each level of kernel this host can run
+static bench kernels("scanner", "The lexer's scanning kernels, and lexing with each", []
+{
+   const size_t size = 1 << 20;
+
+   //Blanks, as between tokens
+   string blanks(size, ' ');
+
+   for (size_t i = 63; i < size; i += 64)
+      blanks[i] = '\n';
+
+   //A comment with no end, but plenty of '*'s and '/'s
+   string comment;
+
+   while (comment.size() < size)
+      comment += "* a comment / with * some / in it ** //\n";
+
+   comment.resize(size);
+
+   //One long name
+   string name;
+
+   while (name.size() < size)
+      name += "abcdefghijklmnopqrstuvwxyz_ABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789";
+
+   name.resize(size);
+
+   string source = functions_source(20000);
+
+   const pair<scanner::isa, const char*> levels[] = {{scanner::isa::SCALAR, "scalar"},
+						     {scanner::isa::SSE2, "SSE2"},
+						     {scanner::isa::AVX2, "AVX2"}};
+
+   for (const auto& lvl : levels)
+   {
+      if (!scanner::select(lvl.first))
+      {
+	 bench::note(string(lvl.second) + ": not on this host");
+
+	 continue;
+      }
+
+      const char* b = blanks.data();
+      const char* c = comment.data();
+      const char* n = name.data();
+
+      bench::report_rate(string("blanks, ") + lvl.second, size, bench::best_of(50, [&]
+      {
+	 bench::sink += scanner::skip_blanks(b, b + size) - b;
+      }));
+
+      bench::report_rate(string("comment close, ") + lvl.second, size, bench::best_of(50, [&]
+      {
+	 bench::sink += scanner::find_comment_close(c, c + size) - c;
+      }));
+
+      bench::report_rate(string("name run, ") + lvl.second, size, bench::best_of(50, [&]
+      {
+	 bench::sink += scanner::skip_name(n, n + size) - n;
+      }));
+
+      bench::report_time(string("lexing 9.6MB, ") + lvl.second, bench::best_of(5, [&]
+      {
+	 lexer lx;
+
+	 bench::sink += lx.lex(source.data(), source.size()).size();
+      }));
+   }
+});
@@ -0,0 +1,80 @@
+#include "bench.hpp"
+
+#include <random>
+
+using namespace std;
+
+string
+functions_source(unsigned n)
+{
+   string src;
+
+   for (unsigned f = 0; f < n; ++f)
+   {
+      string i = to_string(f);
+
+      src += "/*************************************************\n"
+	 " * generated function " + i + "\n"
+	 " *************************************************/\n";
+
+      src += "int func_" + i + "(int alpha_" + i + ", int beta_" + i + ")\n{\n";
+      src += "        int gamma_value;\n        int delta_value;\n";
+      src += "        gamma_value = alpha_" + i + " + beta_" + i + " * alpha_" + i + " - beta_" + i +
+	 ";  // trailing comment here\n";
+      src += "        delta_value = gamma_value / alpha_" + i + " % beta_" + i + ";\n";
+
+      if (f)
+	 src += "        delta_value = func_" + to_string(f - 1) + "(gamma_value, delta_value);\n";
+
+      src += "        return delta_value;\n}\n\n";
+   }
+
+   return src;
+}
+
+string
+names_source(size_t bytes)
+{
+   static const char* words[] = {"int", "float", "return", "for", "while", "void",
+				 "a", "b", "i", "n", "x_1", "sum", "count", "total_value",
+				 "alpha", "beta_2", "gamma", "delta_value", "main", "string",
+				 "=", "+", "*", "<", "==", "0", "1", "42", "0.5"};
+
+   //The same every time
+   mt19937 rng(3);
+
+   string src;
+
+   while (src.size() < bytes)
+   {
+      for (int w = 0; w < 8; ++w)
+      {
+	 src += words[rng() % (sizeof(words) / sizeof(*words))];
+	 src += ' ';
+      }
+
+      src += ";\n";
+   }
+
+   return src;
+}
+
+string
+literals_source(unsigned n)
+{
+   string src;
+
+   for (unsigned f = 0; f < n; ++f)
+   {
+      src += "int k_" + to_string(f) + "(int a)\n{\n";
+      src += "\tint s = " + to_string(f) + " * 16 + 3;\n";
+      src += "\tint t = s * 2 - 1;\n"
+	 "\tint u = a * 4 + t;\n"
+	 "\tu = u * 1 + 0;\n"
+	 "\tint v = t / 2 * a + 5;\n"
+	 "\tu = u + v * 8;\n"
+	 "\treturn u + s;\n}\n\n";
+   }
+
+   return src;
+}
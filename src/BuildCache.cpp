@@ -0,0 +1,189 @@
+#include "BuildCache.hpp"
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <chrono>
+#include <fstream>
+
+using namespace std;
+
+//(Which wants std in scope)
+#include "log.hpp"
+
+//Anything about this compiler that changes what it makes. It's all
+//rebuilt at once, so when it was built will do
+static const char* version = "adze " __DATE__ " " __TIME__;
+
+BuildCache::BuildCache(const string& dr)
+   : dir (dr)
+   , hits (0)
+   , misses (0)
+{
+   //Pruned every run, by size (and LLVM's expiry, a week unused)
+   policy.Interval = std::chrono::seconds(0);
+   policy.MaxSizeBytes = default_limit;
+}
+
+bool
+BuildCache::parse_limit(const string& size, uint64_t& bytes)
+{
+   //(Just the size; nothing else of the policy)
+   llvm::Expected<llvm::CachePruningPolicy> parsed =
+      llvm::parseCachePruningPolicy("cache_size_bytes=" + size);
+
+   if (!parsed || size.empty() || (size.find(':') != string::npos))
+   {
+      Log::log_error(Error(0, 0, string("Bad cache limit '" + size + "'") +
+			   (parsed ? string(".") : ": " + llvm::toString(parsed.takeError()))));
+      return false;
+   }
+
+   bytes = parsed->MaxSizeBytes;
+
+   return true;
+}
+
+void
+BuildCache::SetLimit(uint64_t bytes)
+{
+   policy.MaxSizeBytes = bytes;
+}
+
+void
+BuildCache::SetKey(llvm::StringRef source, int level, const string& target,
+		   const string& what)
+{
+   llvm::SHA1 sha;
+
+   //Each part ends with a '\0', so that they can't run into each other
+   for (llvm::StringRef part : {llvm::StringRef(version),
+	    llvm::StringRef(LLVM_VERSION_STRING),
+	    llvm::StringRef(to_string(level)),
+	    llvm::StringRef(target),
+	    llvm::StringRef(what)})
+   {
+      sha.update(part);
+      sha.update(llvm::StringRef("", 1));
+   }
+
+   sha.update(source);
+
+   key = llvm::toHex(sha.final(), true);
+}
+
+string
+BuildCache::EntryPath() const
+{
+   llvm::SmallString<128> path(dir);
+
+   llvm::sys::path::append(path, "llvmcache-" + key);
+
+   return path.str().str();
+}
+
+unique_ptr<llvm::MemoryBuffer>
+BuildCache::Load()
+{
+   string path = EntryPath();
+
+   int fd;
+
+   if (llvm::sys::fs::openFileForRead(path, fd))
+      return nullptr;
+
+   llvm::ErrorOr<unique_ptr<llvm::MemoryBuffer>> buffer =
+      llvm::MemoryBuffer::getOpenFile(llvm::sys::fs::convertFDToNativeFile(fd), path, -1);
+
+   //Pruning goes by when entries were last used, and access times
+   //can't be relied on
+   llvm::sys::fs::setLastAccessAndModificationTime(fd, std::chrono::system_clock::now());
+
+   llvm::sys::Process::SafelyCloseFileDescriptor(fd);
+
+   return buffer ? std::move(*buffer) : nullptr;
+}
+
+unique_ptr<llvm::MemoryBuffer>
+BuildCache::Find()
+{
+   unique_ptr<llvm::MemoryBuffer> found = Load();
+
+   if (found)
+      ++hits;
+
+   else ++misses;
+
+   return found;
+}
+
+void
+BuildCache::notifyObjectCompiled(const llvm::Module* mod, llvm::MemoryBufferRef obj)
+{
+   if (llvm::sys::fs::create_directories(dir))
+      return;
+
+   //Written under another name, then renamed into place, so no one
+   //ever sees half of it
+   llvm::SmallString<128> temp(dir);
+
+   llvm::sys::path::append(temp, "tmp-%%%%%%%%");
+
+   int fd;
+
+   if (llvm::sys::fs::createUniqueFile(temp, fd, temp))
+      return;
+
+   {
+      llvm::raw_fd_ostream out(fd, true);
+
+      out << obj.getBuffer();
+   }
+
+   if (llvm::sys::fs::rename(temp, EntryPath()))
+      llvm::sys::fs::remove(temp);
+}
+
+unique_ptr<llvm::MemoryBuffer>
+BuildCache::getObject(const llvm::Module* mod)
+{
+   return Load();
+}
+
+void
+BuildCache::Finish(bool stats, ostream& out)
+{
+   llvm::SmallString<128> path(dir);
+
+   llvm::sys::path::append(path, "stats");
+
+   unsigned totalHits = 0;
+   unsigned totalMisses = 0;
+
+   {
+      ifstream in(path.c_str());
+
+      in >> totalHits >> totalMisses;
+   }
+
+   totalHits += hits;
+   totalMisses += misses;
+
+   if (!llvm::sys::fs::create_directories(dir))
+   {
+      ofstream(path.c_str()) << totalHits << " " << totalMisses << endl;
+
+      llvm::pruneCache(dir, policy);
+   }
+
+   if (stats)
+   {
+      out << "Cache " << (hits ? "hit" : "miss") << " (" <<
+	 totalHits << " hits, " << totalMisses << " misses so far)" << endl;
+   }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "llvm/ExecutionEngine/ObjectCache.h"
+#include "llvm/Support/CachePruning.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+class BuildCache : public llvm::ObjectCache
+/*
+  Objects compiled before, kept in a directory, so that compiling the
+  same thing again skips parsing and generating altogether.
+
+  Entries are content-addressed: the key is a SHA-1 of the source and
+  of everything else that decides what comes out (see SetKey()). Each
+  is a file named llvmcache-<key>, as llvm::pruneCache() wants, which
+  keeps the directory under its size limit by removing those used
+  longest ago. Hits and misses are counted in a file of their own.
+
+  Only one thing is ever compiled at a time, so there's just the one
+  key; the Module LLVM passes as an ObjectCache is ignored.
+*/
+{
+private:
+   std::string dir;
+   std::string key; //Hex
+   llvm::CachePruningPolicy policy;
+
+   //This run's (at most one of them)
+   unsigned hits;
+   unsigned misses;
+
+   std::string EntryPath() const;
+   //The entry for key, not counted as a hit or miss; nullptr if none
+   std::unique_ptr<llvm::MemoryBuffer> Load();
+
+public:
+   BuildCache(const std::string& dr);
+
+   //How much the directory holds unless told otherwise
+   static const uint64_t default_limit = 1u << 30;
+
+   //Read the most the directory may hold: bytes, or with a k/m/g
+   //suffix. False (logged) if 'size' isn't one
+   static bool parse_limit(const std::string& size, uint64_t& bytes);
+   void SetLimit(uint64_t bytes);
+
+   /*
+     Key everything after on the source and on this compiler's version
+     and LLVM's, 'level' (-O<level>, or -1), 'target' (see
+     ParseBuild::describe_target()) and 'what' is being made (like an
+     object file, or something to run)
+   */
+   void SetKey(llvm::StringRef source, int level, const std::string& target,
+	       const std::string& what);
+
+   //The object for the key, counted as a hit, or nullptr, counted as a
+   //miss
+   std::unique_ptr<llvm::MemoryBuffer> Find();
+
+   //Record this run's hit or miss, and prune the directory. If 'stats',
+   //print them and the totals so far
+   void Finish(bool stats, std::ostream& out);
+
+   //llvm::ObjectCache
+   void notifyObjectCompiled(const llvm::Module* mod, llvm::MemoryBufferRef obj) override;
+   std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module* mod) override;
+};
@@ -0,0 +1,496 @@
+#include "FlatTree.hpp"
+
+//Flatten()s of each Expression are here, as their Generate()s are in
+//generator.cpp
+#include "exprs/subexprs/VarExpression.hpp"
+#include "exprs/subexprs/LitIntExpression.hpp"
+#include "exprs/subexprs/LitFloatExpression.hpp"
+#include "exprs/subexprs/BinaryExpression.hpp"
+#include "exprs/subexprs/CallExpression.hpp"
+#include "exprs/subexprs/ReturnExpression.hpp"
+#include "exprs/subexprs/SignatureExpression.hpp"
+#include "exprs/subexprs/FunctionExpression.hpp"
+#include "exprs/subexprs/AssignExpression.hpp"
+#include "exprs/subexprs/InitVarExpression.hpp"
+#include "exprs/subexprs/LoopExpression.hpp"
+
+using namespace std;
+
+flat_id
+FlatTree::make_id(kind knd, size_t index)
+{
+   return ((flat_id) knd << 28) | (flat_id) index;
+}
+
+FlatTree::range
+FlatTree::add_kids(llvm::ArrayRef<flat_id> ids)
+{
+   range rng = {(uint32_t) kids.size(), (uint32_t) ids.size()};
+
+   kids.insert(kids.end(), ids.begin(), ids.end());
+
+   return rng;
+}
+
+llvm::ArrayRef<flat_id>
+FlatTree::get_kids(range rng) const
+{
+   return llvm::ArrayRef<flat_id>(kids).slice(rng.first, rng.count);
+}
+
+llvm::ArrayRef<symbol>
+FlatTree::get_rets(const signature& sig) const
+{
+   return llvm::ArrayRef<symbol>(rets).slice(sig.rets.first, sig.rets.count);
+}
+
+llvm::ArrayRef<tuple<symbol, symbol>>
+FlatTree::get_params(const signature& sig) const
+{
+   return llvm::ArrayRef<tuple<symbol, symbol>>(params).slice(sig.params.first, sig.params.count);
+}
+
+flat_id
+FlatTree::add_function(flat_id sig, llvm::ArrayRef<flat_id> stmts)
+{
+   functions.push_back({sig, add_kids(stmts)});
+
+   return make_id(kind::FUNCTION, functions.size() - 1);
+}
+
+flat_id
+FlatTree::add_signature(symbol name,
+			llvm::ArrayRef<symbol> rs,
+			llvm::ArrayRef<tuple<symbol, symbol>> ps)
+{
+   signature sig = {name,
+		    {(uint32_t) rets.size(), (uint32_t) rs.size()},
+		    {(uint32_t) params.size(), (uint32_t) ps.size()}};
+
+   rets.insert(rets.end(), rs.begin(), rs.end());
+   params.insert(params.end(), ps.begin(), ps.end());
+
+   signatures.push_back(sig);
+
+   return make_id(kind::SIGNATURE, signatures.size() - 1);
+}
+
+flat_id
+FlatTree::add_return(llvm::ArrayRef<flat_id> vals)
+{
+   returns.push_back(add_kids(vals));
+
+   return make_id(kind::RETURN, returns.size() - 1);
+}
+
+flat_id
+FlatTree::add_assign(flat_id lhs, flat_id rhs)
+{
+   assigns.emplace_back(lhs, rhs);
+
+   return make_id(kind::ASSIGN, assigns.size() - 1);
+}
+
+flat_id
+FlatTree::add_init_var(symbol name, symbol type)
+{
+   inits.push_back({name, type});
+
+   return make_id(kind::INIT_VAR, inits.size() - 1);
+}
+
+flat_id
+FlatTree::add_var(symbol name, symbol type)
+{
+   vars.push_back({name, type});
+
+   return make_id(kind::VAR, vars.size() - 1);
+}
+
+flat_id
+FlatTree::add_call(symbol name, llvm::ArrayRef<flat_id> args)
+{
+   calls.push_back({name, add_kids(args)});
+
+   return make_id(kind::CALL, calls.size() - 1);
+}
+
+flat_id
+FlatTree::add_binary(token_kind op, flat_id lhs, flat_id rhs)
+{
+   binaries.push_back({op, lhs, rhs});
+
+   return make_id(kind::BINARY, binaries.size() - 1);
+}
+
+flat_id
+FlatTree::add_lit_int(int value)
+{
+   ints.push_back(value);
+
+   return make_id(kind::LIT_INT, ints.size() - 1);
+}
+
+flat_id
+FlatTree::add_lit_float(float value)
+{
+   floats.push_back(value);
+
+   return make_id(kind::LIT_FLOAT, floats.size() - 1);
+}
+
+flat_id
+FlatTree::add_loop(flat_id init, flat_id cond, flat_id step,
+		   llvm::ArrayRef<flat_id> body)
+{
+   loops.push_back({init, cond, step, add_kids(body)});
+
+   return make_id(kind::LOOP, loops.size() - 1);
+}
+
+void
+FlatTree::add_root(flat_id id)
+{
+   roots.push_back(id);
+}
+
+bool
+FlatTree::empty() const
+{
+   return roots.empty();
+}
+
+void
+FlatTree::clear()
+{
+   functions.clear();
+   signatures.clear();
+   returns.clear();
+   assigns.clear();
+   inits.clear();
+   vars.clear();
+   calls.clear();
+   binaries.clear();
+   ints.clear();
+   floats.clear();
+   loops.clear();
+
+   kids.clear();
+   rets.clear();
+   params.clear();
+
+   roots.clear();
+}
+
+ostream&
+FlatTree::print(ostream& stream, const Interner& names) const
+{
+   for (flat_id root : roots)
+      print_node(stream, names, root);
+
+   return stream;
+}
+
+ostream&
+FlatTree::print_node(ostream& stream, const Interner& names, flat_id id) const
+{
+   //Each case prints just as the Expression's print() does
+   uint32_t index = index_of(id);
+
+   switch (kind_of(id))
+   {
+      case kind::FUNCTION:
+      {
+	 const function& func = functions[index];
+	 llvm::ArrayRef<flat_id> stmts = get_kids(func.stmts);
+
+	 stream << "FunctionExpression: " << endl;
+
+	 stream << "[Function signature:]" << endl;
+	 print_node(stream, names, func.sig);
+
+	 for (unsigned int i = 0; i < stmts.size(); ++i)
+	 {
+	    stream << "[Function statement " << i << ":]";
+	    print_node(stream, names, stmts[i]);
+	 }
+
+	 return stream << endl << "FunctionExpression end" << endl;
+      }
+
+      case kind::SIGNATURE:
+      {
+	 const signature& sig = signatures[index];
+
+	 stream << "SignatureExpression: " << names.name(sig.name).str() << endl;
+
+	 llvm::ArrayRef<symbol> rs = get_rets(sig);
+	 llvm::ArrayRef<tuple<symbol, symbol>> ps = get_params(sig);
+
+	 for (unsigned int i = 0; i < rs.size(); ++i)
+	 {
+	    stream << "[Signature return " << i << ":]" << endl << names.name(rs[i]).str();
+	 }
+
+	 stream << endl;
+
+	 for (unsigned int i = 0; i < ps.size(); ++i)
+	 {
+	    stream << "[Signature param " << i << ":]" <<
+	       names.name(get<0>(ps[i])).str() << " " <<
+	       names.name(get<1>(ps[i])).str() << endl;
+	 }
+
+	 stream << endl;
+
+	 return stream << "SignatureExpression end" << endl;
+      }
+
+      case kind::RETURN:
+      {
+	 llvm::ArrayRef<flat_id> vals = get_kids(returns[index]);
+
+	 stream << "ReturnExpression: " << endl;
+
+	 for (unsigned int i = 0; i < vals.size(); ++i)
+	 {
+	    stream << "[Return " << i << ":]" << endl;
+	    print_node(stream, names, vals[i]);
+	 }
+
+	 return stream << "ReturnExpression end" << endl;
+      }
+
+      case kind::ASSIGN:
+      {
+	 stream << "AssignExpression: " <<  endl;
+
+	 stream << "[Assign left hand side:]" << endl;
+	 print_node(stream, names, get<0>(assigns[index]));
+	 stream << "[Assign right hand side:]" << endl;
+	 print_node(stream, names, get<1>(assigns[index]));
+
+	 return stream << "AssignExpression end" << endl;
+      }
+
+      case kind::INIT_VAR:
+	 return stream << "InitVarExpression: " << names.name(inits[index].type).str() <<
+	    " " << names.name(inits[index].name).str() << endl;
+
+      case kind::VAR:
+	 return stream << "VarExpression: " << names.name(vars[index].name).str() <<
+	    ", type: " << names.name(vars[index].type).str() << endl;
+
+      case kind::CALL:
+      {
+	 const call& cl = calls[index];
+	 llvm::ArrayRef<flat_id> args = get_kids(cl.args);
+
+	 stream << "CallExpression: " << names.name(cl.name).str() << endl;
+
+	 for (unsigned int i = 0; i < args.size(); ++i)
+	 {
+	    stream << "[Call argument " << i << ":]" << endl;
+	    print_node(stream, names, args[i]);
+	 }
+
+	 return stream << "CallExpression end" << endl;
+      }
+
+      case kind::BINARY:
+      {
+	 const binary& bin = binaries[index];
+
+	 stream << "BinaryExpression: " << token(bin.op) << endl;
+
+	 stream << "[Binary left hand side:]" << endl;
+	 print_node(stream, names, bin.lhs);
+	 stream << "[Binary right hand side:]" << endl;
+	 print_node(stream, names, bin.rhs);
+
+	 return stream << "BinaryExpression end" << endl;
+      }
+
+      case kind::LIT_INT:
+	 return stream << "LitIntExpression: " << ints[index] << endl;
+
+      case kind::LIT_FLOAT:
+	 return stream << "LitFloatExpression: " << floats[index] << endl;
+
+      case kind::LOOP:
+      {
+	 const loop& lp = loops[index];
+	 llvm::ArrayRef<flat_id> stmts = get_kids(lp.body);
+
+	 stream << "LoopExpression: " << endl;
+
+	 if (lp.init != none)
+	 {
+	    stream << "[Loop init:]" << endl;
+	    print_node(stream, names, lp.init);
+	 }
+
+	 stream << "[Loop condition:]" << endl;
+	 print_node(stream, names, lp.cond);
+
+	 if (lp.step != none)
+	 {
+	    stream << "[Loop step:]" << endl;
+	    print_node(stream, names, lp.step);
+	 }
+
+	 for (unsigned int i = 0; i < stmts.size(); ++i)
+	 {
+	    stream << "[Loop statement " << i << ":]";
+	    print_node(stream, names, stmts[i]);
+	 }
+
+	 return stream << "LoopExpression end" << endl;
+      }
+   }
+
+   return stream;
+}
+
+//Flatten()s
+
+flat_id
+FunctionExpression::Flatten(FlatTree& flat)
+{
+   flat_id sig = signature->Flatten(flat);
+
+   if (sig == FlatTree::none)
+      return FlatTree::none;
+
+   llvm::SmallVector<flat_id, 16> stmts;
+
+   for (Expression* stmt : statements)
+   {
+      flat_id id = stmt->Flatten(flat);
+
+      if (id == FlatTree::none)
+	 return FlatTree::none;
+
+      stmts.push_back(id);
+   }
+
+   return flat.add_function(sig, stmts);
+}
+
+flat_id
+SignatureExpression::Flatten(FlatTree& flat)
+{
+   return flat.add_signature(funcName, rets, params);
+}
+
+flat_id
+ReturnExpression::Flatten(FlatTree& flat)
+{
+   llvm::SmallVector<flat_id, 4> vals;
+
+   for (Expression* ret : rets)
+   {
+      flat_id id = ret->Flatten(flat);
+
+      if (id == FlatTree::none)
+	 return FlatTree::none;
+
+      vals.push_back(id);
+   }
+
+   return flat.add_return(vals);
+}
+
+flat_id
+AssignExpression::Flatten(FlatTree& flat)
+{
+   flat_id left = lhs->Flatten(flat);
+   flat_id right = rhs->Flatten(flat);
+
+   if ((left == FlatTree::none) or (right == FlatTree::none))
+      return FlatTree::none;
+
+   return flat.add_assign(left, right);
+}
+
+flat_id
+InitVarExpression::Flatten(FlatTree& flat)
+{
+   return flat.add_init_var(varName, typName);
+}
+
+flat_id
+VarExpression::Flatten(FlatTree& flat)
+{
+   return flat.add_var(varName, typeName);
+}
+
+flat_id
+CallExpression::Flatten(FlatTree& flat)
+{
+   llvm::SmallVector<flat_id, 8> ids;
+
+   for (Expression* arg : args)
+   {
+      flat_id id = arg->Flatten(flat);
+
+      if (id == FlatTree::none)
+	 return FlatTree::none;
+
+      ids.push_back(id);
+   }
+
+   return flat.add_call(name, ids);
+}
+
+flat_id
+BinaryExpression::Flatten(FlatTree& flat)
+{
+   flat_id left = lhs->Flatten(flat);
+   flat_id right = rhs->Flatten(flat);
+
+   if ((left == FlatTree::none) or (right == FlatTree::none))
+      return FlatTree::none;
+
+   return flat.add_binary(op, left, right);
+}
+
+flat_id
+LitIntExpression::Flatten(FlatTree& flat)
+{
+   return flat.add_lit_int(value);
+}
+
+flat_id
+LitFloatExpression::Flatten(FlatTree& flat)
+{
+   return flat.add_lit_float(value);
+}
+
+flat_id
+LoopExpression::Flatten(FlatTree& flat)
+{
+   flat_id in = init ? init->Flatten(flat) : FlatTree::none;
+   flat_id cnd = cond->Flatten(flat);
+   flat_id stp = step ? step->Flatten(flat) : FlatTree::none;
+
+   if ((init && (in == FlatTree::none)) or (cnd == FlatTree::none) or
+       (step && (stp == FlatTree::none)))
+   {
+      return FlatTree::none;
+   }
+
+   llvm::SmallVector<flat_id, 16> stmts;
+
+   for (Expression* stmt : body)
+   {
+      flat_id id = stmt->Flatten(flat);
+
+      if (id == FlatTree::none)
+	 return FlatTree::none;
+
+      stmts.push_back(id);
+   }
+
+   return flat.add_loop(in, cnd, stp, stmts);
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "lexer.hpp"
+#include "Interner.hpp"
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Value.h"
+
+#include <cstdint>
+#include <iostream>
+#include <tuple>
+#include <vector>
+
+class ParseScope;
+class ParseBuild;
+class ParseInfo;
+
+//A node of a FlatTree: its kind in the top 4 bits, and its index in
+//that kind's array in the rest
+typedef uint32_t flat_id;
+
+class FlatTree
+/*
+  The parsed tree again, laid out flat for generation: nodes of each
+  kind sit together in their own array, and refer to their children
+  by flat_id rather than by pointer. Lists of children (statements,
+  arguments, returned values) are runs of one shared array.
+
+  It's built from the Expression tree (Expression::Flatten()), after
+  parsing, and should print and generate exactly as that does. Any
+  Expression that can't be flattened returns FlatTree::none, and the
+  Parser falls back to generating from the Expression tree.
+*/
+{
+public:
+   enum class kind : uint8_t
+   {
+      FUNCTION,
+      SIGNATURE,
+      RETURN,
+      ASSIGN,
+      INIT_VAR,
+      VAR,
+      CALL,
+      BINARY,
+      LIT_INT,
+      LIT_FLOAT,
+      LOOP
+   };
+
+   static const flat_id none = ~(flat_id) 0;
+
+   static kind kind_of(flat_id id) { return (kind) (id >> 28); }
+   static uint32_t index_of(flat_id id) { return id & 0x0fffffff; }
+
+private:
+   //A run of some shared array
+   struct range
+   {
+      uint32_t first;
+      uint32_t count;
+   };
+
+   struct function
+   {
+      flat_id sig;
+      range stmts; //In kids
+   };
+
+   struct signature
+   {
+      symbol name;
+      range rets; //In rets
+      range params; //In params
+   };
+
+   struct binary
+   {
+      token_kind op;
+      flat_id lhs;
+      flat_id rhs;
+   };
+
+   //name and type symbols, for VAR and INIT_VAR
+   struct variable
+   {
+      symbol name;
+      symbol type;
+   };
+
+   struct call
+   {
+      symbol name;
+      range args; //In kids
+   };
+
+   struct loop
+   {
+      flat_id init; //none for a while
+      flat_id cond;
+      flat_id step; //none for a while
+      range body; //In kids
+   };
+
+   std::vector<function> functions;
+   std::vector<signature> signatures;
+   std::vector<range> returns; //Values returned, in kids
+   std::vector<std::tuple<flat_id, flat_id>> assigns; //lhs, rhs
+   std::vector<variable> inits;
+   std::vector<variable> vars;
+   std::vector<call> calls;
+   std::vector<binary> binaries;
+   std::vector<int> ints;
+   std::vector<float> floats;
+   std::vector<loop> loops;
+
+   std::vector<flat_id> kids;
+   std::vector<symbol> rets;
+   std::vector<std::tuple<symbol, symbol>> params;
+
+   //Top level, in order parsed
+   std::vector<flat_id> roots;
+
+   static flat_id make_id(kind knd, size_t index);
+
+   range add_kids(llvm::ArrayRef<flat_id> ids);
+   llvm::ArrayRef<flat_id> get_kids(range rng) const;
+   llvm::ArrayRef<symbol> get_rets(const signature& sig) const;
+   llvm::ArrayRef<std::tuple<symbol, symbol>> get_params(const signature& sig) const;
+
+   std::ostream& print_node(std::ostream& stream, const Interner& names, flat_id id) const;
+
+   llvm::Value* GenerateNode(flat_id id, ParseScope& scope, ParseBuild& build, ParseInfo& info);
+   llvm::Value* GenerateLHS(flat_id id, ParseScope& scope, ParseBuild& build, ParseInfo& info);
+
+public:
+   //Children have to be added before their parents
+   flat_id add_function(flat_id sig, llvm::ArrayRef<flat_id> stmts);
+   flat_id add_signature(symbol name,
+			 llvm::ArrayRef<symbol> rs,
+			 llvm::ArrayRef<std::tuple<symbol, symbol>> ps);
+   flat_id add_return(llvm::ArrayRef<flat_id> vals);
+   flat_id add_assign(flat_id lhs, flat_id rhs);
+   flat_id add_init_var(symbol name, symbol type);
+   flat_id add_var(symbol name, symbol type);
+   flat_id add_call(symbol name, llvm::ArrayRef<flat_id> args);
+   flat_id add_binary(token_kind op, flat_id lhs, flat_id rhs);
+   flat_id add_lit_int(int value);
+   flat_id add_lit_float(float value);
+   flat_id add_loop(flat_id init, flat_id cond, flat_id step,
+		    llvm::ArrayRef<flat_id> body);
+
+   void add_root(flat_id id);
+
+   bool empty() const;
+   void clear();
+
+   std::ostream& print(std::ostream& stream, const Interner& names) const;
+
+   //Generate every root in order, as Parser::Generate() would
+   void Generate(ParseScope& scope, ParseBuild& build, ParseInfo& info,
+		 std::vector<llvm::Value*>& generated);
+   //Just roots [first, last)
+   void Generate(ParseScope& scope, ParseBuild& build, ParseInfo& info,
+		 std::vector<llvm::Value*>& generated,
+		 size_t first, size_t last);
+};
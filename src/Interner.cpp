@@ -0,0 +1,60 @@
+#include "Interner.hpp"
+
+static const size_t nKeywords = sizeof(keywords) / sizeof(keyword);
+static const size_t nPrimitives = sizeof(primitives) / sizeof(keyword);
+
+Interner::Interner()
+{
+   intern(llvm::StringRef());
+
+   for (size_t i = 0; i < nKeywords; ++i)
+      intern(llvm::StringRef(keywords[i].name, keywords[i].len));
+
+   for (size_t i = 0; i < nPrimitives; ++i)
+      intern(llvm::StringRef(primitives[i].name, primitives[i].len));
+}
+
+symbol
+Interner::intern(llvm::StringRef name)
+{
+   auto ins = ids.try_emplace(name, (symbol) names.size());
+
+   if (ins.second)
+   {
+      //Refer to the table's own copy of the name
+      names.push_back(ins.first->getKey());
+   }
+
+   return ins.first->getValue();
+}
+
+llvm::StringRef
+Interner::name(symbol sym) const
+{
+   return names[sym];
+}
+
+size_t
+Interner::size() const
+{
+   return names.size();
+}
+
+token_kind
+Interner::builtin_kind(symbol sym)
+{
+   //See constructor for the order
+   if ((sym < 1) || (sym > nKeywords + nPrimitives))
+      return token_kind::INVALID;
+
+   else if (sym <= nKeywords)
+      return keywords[sym - 1].kind;
+
+   else return primitives[sym - 1 - nKeywords].kind;
+}
+
+symbol
+Interner::builtin_end()
+{
+   return 1 + nKeywords + nPrimitives;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "lexer.hpp"
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Allocator.h"
+
+#include <vector>
+
+class Interner
+/*
+  Table of names. Each distinct name (of a variable, function or type)
+  is given a small integer symbol the first time the lexer sees it, so
+  that the parser, scope and generation compare and index by symbol
+  rather than by string. The name itself is stored once, here.
+
+  Keywords and primitives are interned first, in the order of their
+  tables in lexer.hpp, so their symbols are fixed.
+*/
+{
+private:
+   llvm::StringMap<symbol, llvm::BumpPtrAllocator> ids;
+
+   //symbol -> name; the strings live in ids
+   std::vector<llvm::StringRef> names;
+
+public:
+   //Symbol 0 is the empty name: 'no name'
+   static const symbol none = 0;
+
+   Interner();
+
+   Interner(const Interner&) = delete;
+   Interner& operator= (const Interner&) = delete;
+
+   symbol intern(llvm::StringRef name);
+   llvm::StringRef name(symbol sym) const;
+   size_t size() const;
+
+   //The token_kind of a keyword or primitive's symbol; INVALID if the
+   //symbol isn't one of those
+   static token_kind builtin_kind(symbol sym);
+
+   //Symbols below this are none, keywords and primitives
+   static symbol builtin_end();
+};
@@ -0,0 +1,250 @@
+#include "LazyJIT.hpp"
+
+#include "ParseBuild.hpp"
+#include "ParseInfo.hpp"
+#include "ParseScope.hpp"
+#include "log.hpp"
+
+#include "exprs/subexprs/FunctionExpression.hpp"
+
+#include "llvm/Support/TargetSelect.h"
+
+#include <cstdlib>
+
+using namespace std;
+
+const uint32_t LazyJIT::none;
+
+//Parser only ever parses FunctionExpressions at the top level
+static Expression*
+signature_of(Expression* func)
+{
+   return static_cast<FunctionExpression*>(func)->GetSignature();
+}
+
+//Where a stub goes, when called, if its function couldn't be
+//generated
+static void
+lazy_failure()
+{
+   Log::log_error(Error(0, 0, string("Failed to generate a function being called.")));
+
+   Log::print();
+
+   exit(1);
+}
+
+class LazyJIT::FunctionUnit : public llvm::orc::MaterializationUnit
+/*
+  The definition of one function, generated when it's first wanted
+*/
+{
+private:
+   LazyJIT& lazy;
+   size_t i; //In parsed
+
+public:
+   FunctionUnit(LazyJIT& lz, size_t index, llvm::orc::SymbolStringPtr name)
+      : MaterializationUnit(Interface({{name, llvm::JITSymbolFlags::Exported |
+					       llvm::JITSymbolFlags::Callable}},
+				      nullptr))
+      , lazy (lz)
+      , i (index)
+   {
+   }
+
+   llvm::StringRef getName() const override
+   {
+      return "adze function";
+   }
+
+private:
+   void materialize(unique_ptr<llvm::orc::MaterializationResponsibility> r) override
+   {
+      llvm::orc::ThreadSafeModule mod;
+
+      if (!lazy.Generate(i, mod))
+      {
+	 r->failMaterialization();
+
+	 return;
+      }
+
+      lazy.jit->getIRTransformLayer().emit(std::move(r), std::move(mod));
+   }
+
+   void discard(const llvm::orc::JITDylib& jd, const llvm::orc::SymbolStringPtr& name) override
+   {
+      //Its one symbol is never defined anywhere else
+   }
+};
+
+LazyJIT::LazyJIT(Interner& nms, ParseArena& ar, const vector<Expression*>& prs, int lvl,
+		 bool sa, bool fm, unsigned vw, unsigned uc)
+   : names (nms)
+   , arena (ar)
+   , parsed (prs)
+   , level (lvl)
+   , ssa (sa)
+   , fastMath (fm)
+   , vectorizeWidth (vw)
+   , unrollCount (uc)
+{
+   for (size_t i = 0; i < parsed.size(); ++i)
+   {
+      symbol name = signature_of(parsed[i])->GetFuncName();
+
+      if (name >= index.size())
+	 index.resize(name + 1, none);
+
+      if (index[name] == none)
+	 index[name] = i;
+   }
+}
+
+LazyJIT::~LazyJIT()
+{
+}
+
+bool
+LazyJIT::Generate(size_t i, llvm::orc::ThreadSafeModule& out)
+{
+   ParseBuild build;
+   ParseScope scope;
+   ParseInfo info(build, names, arena);
+
+   build.SetSSA(ssa);
+   build.SetFastMath(fastMath);
+   build.SetLoopHints(vectorizeWidth, unrollCount);
+   build.GetModule()->setDataLayout(jit->getDataLayout());
+
+   //What it calls is declared when it comes to it, if it's defined
+   //before this one (as generating in one go would have it)
+   build.SetDeclarer([&] (symbol name) -> llvm::Function*
+   {
+      if ((name >= index.size()) || (index[name] >= i))
+	 return nullptr;
+
+      return llvm::cast<llvm::Function>(signature_of(parsed[index[name]])->Generate(scope, build, info));
+   });
+
+   //Errors in its statements are only logged, but leave it unfit to
+   //run
+   size_t errors = Log::count();
+
+   if (!parsed[i]->Generate(scope, build, info) || (Log::count() > errors))
+      return false;
+
+   if (level >= 0)
+      build.Optimise(level);
+
+   out = llvm::orc::ThreadSafeModule(std::move(build.GetModule()), build.TakeContext());
+
+   return true;
+}
+
+bool
+LazyJIT::Run(const string& entry, ostream& out)
+{
+   auto fail = [&] (llvm::Error err)
+   {
+      Log::log_error(Error(0, 0, string("Couldn't run '" + entry + "': " +
+					llvm::toString(std::move(err)))));
+      return false;
+   };
+
+   symbol entryName = names.intern(entry);
+
+   if ((entryName >= index.size()) || (index[entryName] == none))
+   {
+      Log::log_error(Error(0, 0, string("No function '" + entry + "' to run.")));
+
+      return false;
+   }
+
+   llvm::InitializeNativeTarget();
+   llvm::InitializeNativeTargetAsmPrinter();
+
+   llvm::Expected<unique_ptr<llvm::orc::LLJIT>> created = llvm::orc::LLJITBuilder().create();
+
+   if (!created)
+      return fail(created.takeError());
+
+   jit = std::move(*created);
+
+   if (llvm::Error err = ParseBuild::link_process(*jit))
+      return fail(std::move(err));
+
+   llvm::orc::JITDylib& stubsLib = jit->getMainJITDylib();
+
+   llvm::Expected<unique_ptr<llvm::orc::LazyCallThroughManager>> lctm =
+      llvm::orc::createLocalLazyCallThroughManager(jit->getTargetTriple(),
+						   jit->getExecutionSession(),
+						   llvm::pointerToJITTargetAddress(&lazy_failure));
+   if (!lctm)
+      return fail(lctm.takeError());
+
+   callThrough = std::move(*lctm);
+   stubs = llvm::orc::createLocalIndirectStubsManagerBuilder(jit->getTargetTriple())();
+
+   llvm::Expected<llvm::orc::JITDylib&> defsLib = jit->createJITDylib("adze.defs");
+
+   if (!defsLib)
+      return fail(defsLib.takeError());
+
+   //Names in definitions resolve to the stubs, not to each other
+   defsLib->setLinkOrder({{&stubsLib, llvm::orc::JITDylibLookupFlags::MatchAllSymbols}},
+			 false);
+
+   const llvm::JITSymbolFlags flags = llvm::JITSymbolFlags::Exported |
+      llvm::JITSymbolFlags::Callable;
+
+   //A unit per stub, too, so each stub is only made when something
+   //that calls it is
+   for (symbol name = 0; name < index.size(); ++name)
+   {
+      if (index[name] == none)
+	 continue;
+
+      llvm::orc::SymbolStringPtr mangled = jit->mangleAndIntern(names.name(name));
+
+      if (llvm::Error err = defsLib->define(make_unique<FunctionUnit>(*this, index[name], mangled)))
+	 return fail(std::move(err));
+
+      llvm::orc::SymbolAliasMap alias;
+
+      alias[mangled] = llvm::orc::SymbolAliasMapEntry(mangled, flags);
+
+      if (llvm::Error err = stubsLib.define(llvm::orc::lazyReexports(*callThrough, *stubs,
+								      *defsLib, std::move(alias))))
+	 return fail(std::move(err));
+   }
+
+   //The runner (see ParseBuild::BuildRunner()), calling the entry's
+   //stub
+   ParseBuild build;
+   ParseScope scope;
+   ParseInfo info(build, names, arena);
+
+   build.GetModule()->setDataLayout(jit->getDataLayout());
+
+   llvm::Function* func = llvm::cast<llvm::Function>(signature_of(parsed[index[entryName]])->Generate(scope, build, info));
+
+   if (func->arg_size())
+   {
+      Log::log_error(Error(0, 0, string("Can't run '" + entry + "'; it takes params.")));
+
+      return false;
+   }
+
+   build.BuildRunner(func);
+
+   if (llvm::Error err = jit->addIRModule(llvm::orc::ThreadSafeModule(std::move(build.GetModule()),
+								       build.TakeContext())))
+      return fail(std::move(err));
+
+   if (llvm::Error err = ParseBuild::run_entry(*jit, out))
+      return fail(std::move(err));
+
+   return true;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Interner.hpp"
+#include "ParseArena.hpp"
+
+#include "llvm/ExecutionEngine/Orc/IndirectionUtils.h"
+#include "llvm/ExecutionEngine/Orc/LazyReexports.h"
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Expression;
+
+class LazyJIT
+/*
+  Runs what's been parsed, generating each function (IR, then machine
+  code) only when it's first called, so that starting up costs about
+  the same however many functions there are that never get called.
+
+  Every function gets a lazy stub (an ORC lazy reexport) in the JIT's
+  main JITDylib, keyed by the name from its SignatureExpression. Its
+  definition is in another JITDylib, as a FunctionUnit that generates
+  it from its FunctionExpression the first time its stub is called
+  through. That JITDylib resolves names against the stubs rather than
+  itself, so generating one function never pulls in those it calls;
+  they're just declared.
+
+  Errors in a function are only found when it's generated, and end the
+  run there.
+*/
+{
+private:
+   class FunctionUnit;
+
+   static const uint32_t none = ~(uint32_t) 0;
+
+   Interner& names;
+   ParseArena& arena; //(Only as ParseInfo wants one)
+   const std::vector<Expression*>& parsed;
+
+   int level; //-O level to optimise each function at, or -1
+   bool ssa; //See ParseBuild::SetSSA()
+   bool fastMath; //See ParseBuild::SetFastMath()
+   unsigned vectorizeWidth; //See ParseBuild::SetLoopHints()
+   unsigned unrollCount;
+
+   //Index in parsed of each function, by symbol of its name, or none.
+   //Only the first of two with the same name is ever run.
+   std::vector<uint32_t> index;
+
+   std::unique_ptr<llvm::orc::LLJIT> jit;
+   std::unique_ptr<llvm::orc::LazyCallThroughManager> callThrough;
+   std::unique_ptr<llvm::orc::IndirectStubsManager> stubs;
+
+   //IR for parsed[i], on its own in a module with its own context;
+   //false (with errors logged) if it can't be generated
+   bool Generate(size_t i, llvm::orc::ThreadSafeModule& out);
+
+public:
+   LazyJIT(Interner& nms, ParseArena& ar, const std::vector<Expression*>& prs, int lvl,
+	   bool sa, bool fm, unsigned vw, unsigned uc);
+   ~LazyJIT();
+
+   //As ParseBuild::Run()
+   bool Run(const std::string& entry, std::ostream& out);
+};
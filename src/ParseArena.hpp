@@ -0,0 +1,56 @@
+#pragma once
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/Support/Allocator.h"
+
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+class ParseArena
+/*
+  Memory for the parsed tree. Every Expression, and every array of
+  children hanging off one, is bump-allocated from here, and the lot
+  is released in one go when the arena is (ie with the Parser).
+
+  Nothing in here is ever destroyed one by one, so nodes mustn't own
+  anything with a destructor: children are raw Expression*s, and
+  lists of them are ArrayRefs into the arena, not vectors.
+*/
+{
+private:
+   llvm::BumpPtrAllocator alloc;
+
+public:
+   ParseArena() = default;
+
+   ParseArena(const ParseArena&) = delete;
+   ParseArena& operator= (const ParseArena&) = delete;
+
+   //Construct a node in the arena
+   template <typename T, typename... Args>
+   T* make(Args&&... args)
+   {
+      static_assert(std::is_trivially_destructible<T>::value,
+		    "arena nodes are never destroyed");
+
+      return new (alloc.Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+   }
+
+   //Copy a (usually stack-built) list into the arena
+   template <typename T>
+   llvm::ArrayRef<T> copy(llvm::ArrayRef<T> items)
+   {
+      static_assert(std::is_trivially_destructible<T>::value,
+		    "arena arrays are never destroyed");
+
+      if (items.empty())
+	 return llvm::ArrayRef<T>();
+
+      T* mem = alloc.Allocate<T>(items.size());
+      std::uninitialized_copy(items.begin(), items.end(), mem);
+
+      return llvm::ArrayRef<T>(mem, items.size());
+   }
+};
@@ -1,18 +1,42 @@
 #include "ParseBuild.hpp"
 
+#include "log.hpp"
+
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/BasicBlock.h"
 #include "llvm/IR/Verifier.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/Passes/PassBuilder.h"
+#include "llvm/ExecutionEngine/ObjectCache.h"
+#include "llvm/ExecutionEngine/Orc/CompileUtils.h"
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/MC/MCSubtargetInfo.h"
+#include "llvm/MC/SubtargetFeature.h"
+#include "llvm/MC/TargetRegistry.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/TargetSelect.h"
 
 ParseBuild::ParseBuild()
-   : builder (context)
+   : context (std::make_unique<llvm::LLVMContext>())
+   , builder (*context)
+   , jitTarget (false)
+   , targetLevel (0)
+   , diagnostics (&llvm::errs())
+   , ssa (false)
+   , fastMath (false)
+   , vectorizeWidth (0)
+   , unrollCount (0)
+   , allocBlock (nullptr)
 {
-   module = llvm::make_unique<llvm::Module>("adze", context);
+   module = std::make_unique<llvm::Module>("adze", *context);
 }
 
 llvm::LLVMContext&
-ParseBuild::GetContext() { return context; }
+ParseBuild::GetContext() { return *context; }
 
 llvm::IRBuilder<>&
 ParseBuild::GetBuilder() { return builder; }
@@ -20,14 +44,24 @@ ParseBuild::GetBuilder() { return builder; }
 unique_ptr<llvm::Module>&
 ParseBuild::GetModule() { return module; }
 
+unique_ptr<llvm::LLVMContext>
+ParseBuild::TakeContext() { return std::move(context); }
+
+llvm::raw_ostream&
+ParseBuild::GetDiagnostics() { return *diagnostics; }
+
+void
+ParseBuild::SetDiagnostics(llvm::raw_ostream& os) { diagnostics = &os; }
+
 llvm::AllocaInst*
 ParseBuild::allocate_instruction(ParseScope& scope,
-				 llvm::Type* typ, const string& nam)
+				 llvm::Type* typ,
+				 symbol sym, llvm::StringRef nam)
 {
    /*
      Insert instruction to allocate stack space for (mutable)
-     variable - but insert it at the start of the current block,
-     since that's what LLVM advises to do. 
+     variable - but insert it at the start of the function's entry
+     block, since that's what LLVM advises to do. 
 
      Actually it's not quite the
      start - it's at the end of a section, at the start of the block,
@@ -39,9 +73,8 @@ ParseBuild::allocate_instruction(ParseScope& scope,
    llvm::BasicBlock::iterator oldLoc = builder.GetInsertPoint();
 
    /*
-     NB: same block. So this works with blocks other than function
-     entries; scope would be affected by inserting an init into the
-     parent block
+     NB: always the entry block, wherever generation is (like in a
+     loop's body), so each alloca is done once
      
      ++allocInsert because allocInsert is the one previous.
      The alternative doesn't work bc inserting directly 'after' the
@@ -51,7 +84,9 @@ ParseBuild::allocate_instruction(ParseScope& scope,
      As a result allocInsert would equal oldLoc at all points,
      defeating the entire point.
    */
-   builder.SetInsertPoint(builder.GetInsertBlock(),
+   llvm::BasicBlock* oldBlock = builder.GetInsertBlock();
+
+   builder.SetInsertPoint(allocBlock,
 			  ++allocInsert);
    
    llvm::AllocaInst* alloc = builder.CreateAlloca(typ,
@@ -63,26 +98,620 @@ ParseBuild::allocate_instruction(ParseScope& scope,
 
    //Restore old point of insertion (which hasn't changed relative to
    //the instructions)
-   builder.SetInsertPoint(builder.GetInsertBlock(),
+   builder.SetInsertPoint(oldBlock,
 			  oldLoc);
 
-   scope.push_to_scope(nam, alloc);
+   scope.push_to_scope(sym, alloc);
 
    return alloc;
 }
 
+void
+ParseBuild::SetSSA(bool on) { ssa = on; }
+
+bool
+ParseBuild::IsSSA() const { return ssa; }
+
+void
+ParseBuild::SetFastMath(bool on)
+{
+   fastMath = on;
+
+   builder.setFastMathFlags(on ? llvm::FastMathFlags::getFast() : llvm::FastMathFlags());
+}
+
+bool
+ParseBuild::IsFastMath() const { return fastMath; }
+
+void
+ParseBuild::SetLoopHints(unsigned width, unsigned unroll)
+{
+   vectorizeWidth = width;
+   unrollCount = unroll;
+}
+
+llvm::MDNode*
+ParseBuild::MakeLoopID()
+{
+   if (!vectorizeWidth && !unrollCount)
+      return nullptr;
+
+   //The first operand is the node itself, filled in below
+   llvm::SmallVector<llvm::Metadata*, 4> ops = {nullptr};
+
+   auto hint = [&] (const char* name, llvm::Constant* val)
+   {
+      ops.push_back(llvm::MDNode::get(*context, {llvm::MDString::get(*context, name),
+						 llvm::ConstantAsMetadata::get(val)}));
+   };
+
+   if (vectorizeWidth)
+   {
+      hint("llvm.loop.vectorize.enable", builder.getTrue());
+      hint("llvm.loop.vectorize.width", builder.getInt32(vectorizeWidth));
+   }
+
+   if (unrollCount)
+      hint("llvm.loop.unroll.count", builder.getInt32(unrollCount));
+
+   llvm::MDNode* id = llvm::MDNode::getDistinct(*context, ops);
+
+   id->replaceOperandWith(0, id);
+
+   return id;
+}
+
+llvm::BasicBlock*
+ParseBuild::NewBlock(const llvm::Twine& name)
+{
+   return llvm::BasicBlock::Create(*context, name, builder.GetInsertBlock()->getParent());
+}
+
+void
+ParseBuild::SetBlock(llvm::BasicBlock* block)
+{
+   builder.SetInsertPoint(block);
+}
+
+void
+ParseBuild::SealBlock(llvm::BasicBlock* block)
+{
+   if (ssa)
+      vars.Seal(block);
+}
+
+llvm::AllocaInst*
+ParseBuild::declare_variable(ParseScope& scope,
+			     llvm::Type* typ,
+			     symbol sym, llvm::StringRef nam)
+{
+   if (!ssa)
+      return allocate_instruction(scope, typ, sym, nam);
+
+   llvm::AllocaInst* var = vars.Declare(typ, nam);
+
+   scope.push_to_scope(sym, var);
+
+   return var;
+}
+
+llvm::Value*
+ParseBuild::ReadVariable(llvm::AllocaInst* var, llvm::StringRef nam)
+{
+   if (ssa)
+      return vars.Read(var, builder.GetInsertBlock());
+
+   return builder.CreateLoad(var->getAllocatedType(), var, nam);
+}
+
+llvm::Value*
+ParseBuild::WriteVariable(llvm::AllocaInst* var, llvm::Value* val)
+{
+   if (!ssa)
+      return builder.CreateStore(val, var);
+
+   vars.Write(var, builder.GetInsertBlock(), val);
+
+   return val;
+}
+
+llvm::Function*
+ParseBuild::GetFunction(symbol name) const
+{
+   return (name < functions.size()) ? functions[name] : nullptr;
+}
+
+void
+ParseBuild::AddFunction(symbol name, llvm::Function* func)
+{
+   if (name >= functions.size())
+      functions.resize(name + 1, nullptr);
+
+   functions[name] = func;
+}
+
+llvm::Function*
+ParseBuild::GetCallee(symbol name)
+{
+   llvm::Function* func = GetFunction(name);
+
+   if (!func && declarer)
+      func = declarer(name);
+
+   return func;
+}
+
+void
+ParseBuild::SetDeclarer(std::function<llvm::Function*(symbol)> decl)
+{
+   declarer = std::move(decl);
+}
+
 void
 ParseBuild::BuildFunction(ParseScope& scope, llvm::Function* func)
 {
-   llvm::BasicBlock* block = llvm::BasicBlock::Create(context,
+   llvm::BasicBlock* block = llvm::BasicBlock::Create(*context,
 						      "entry",
 						      func);
 
+   //What the flags on each op say, for the function as a whole (which
+   //is what codegen goes by)
+   if (fastMath)
+   {
+      for (const char* attr : {"unsafe-fp-math", "no-infs-fp-math", "no-nans-fp-math",
+			       "no-signed-zeros-fp-math", "approx-func-fp-math"})
+	 func->addFnAttr(attr, "true");
+   }
+
    builder.SetInsertPoint(block);
 
    //Initialise allocInsert (pointer to last alloc at start of the
    //entry block)
+   allocBlock = block;
    allocInsert = block->begin();
 
+   //Nothing jumps back to the entry block
+   if (ssa)
+      vars.Seal(block);
+
    scope.push_scope();
 }
+
+void
+ParseBuild::FinishFunction()
+{
+   vars.Finish();
+}
+
+void
+ParseBuild::Optimise(unsigned level)
+{
+   static const llvm::OptimizationLevel levels[] = {llvm::OptimizationLevel::O0,
+						    llvm::OptimizationLevel::O1,
+						    llvm::OptimizationLevel::O2,
+						    llvm::OptimizationLevel::O3};
+
+   llvm::LoopAnalysisManager lam;
+   llvm::FunctionAnalysisManager fam;
+   llvm::CGSCCAnalysisManager cgam;
+   llvm::ModuleAnalysisManager mam;
+
+   //Knowing the target lets passes (like the vectorisers) use what it
+   //has
+   llvm::PassBuilder passes(machine.get());
+
+   passes.registerModuleAnalyses(mam);
+   passes.registerCGSCCAnalyses(cgam);
+   passes.registerFunctionAnalyses(fam);
+   passes.registerLoopAnalyses(lam);
+   passes.crossRegisterProxies(lam, fam, cgam, mam);
+
+   //-O0 is its own pipeline; the others won't take O0
+   llvm::ModulePassManager pipeline = level ?
+      passes.buildPerModuleDefaultPipeline(levels[std::min(level, 3u)]) :
+      passes.buildO0DefaultPipeline(llvm::OptimizationLevel::O0);
+
+   pipeline.run(*module, mam);
+}
+
+ParseBuild::stats
+ParseBuild::GetStats() const
+{
+   stats st = {0, 0, 0, 0};
+
+   for (const llvm::Function& func : *module)
+   {
+      if (func.isDeclaration())
+	 continue;
+
+      ++st.functions;
+      st.blocks += func.size();
+      st.instructions += func.getInstructionCount();
+   }
+
+   llvm::SmallVector<char, 0> bitcode;
+   llvm::raw_svector_ostream stream(bitcode);
+
+   llvm::WriteBitcodeToFile(*module, stream);
+
+   st.bitcode = bitcode.size();
+
+   return st;
+}
+
+void
+ParseBuild::resolve_cpu(const string& cpu, string& name, string& features)
+{
+   name = cpu;
+   features.clear();
+
+   if (cpu == "native")
+   {
+      name = llvm::sys::getHostCPUName().str();
+
+      llvm::StringMap<bool> hostFeatures;
+      llvm::SubtargetFeatures all;
+
+      if (llvm::sys::getHostCPUFeatures(hostFeatures))
+      {
+	 for (const auto& feature : hostFeatures)
+	    all.AddFeature(feature.first(), feature.second);
+      }
+
+      features = all.getString();
+   }
+}
+
+string
+ParseBuild::describe_target(const string& cpu)
+{
+   string name;
+   string features;
+
+   resolve_cpu(cpu, name, features);
+
+   return llvm::sys::getDefaultTargetTriple() + " " + name + " " + features;
+}
+
+bool
+ParseBuild::SetTarget(const string& cpu, unsigned level)
+{
+   static const llvm::CodeGenOpt::Level levels[] = {llvm::CodeGenOpt::None,
+						    llvm::CodeGenOpt::Less,
+						    llvm::CodeGenOpt::Default,
+						    llvm::CodeGenOpt::Aggressive};
+
+   llvm::InitializeNativeTarget();
+   llvm::InitializeNativeTargetAsmPrinter();
+
+   string triple = llvm::sys::getDefaultTargetTriple();
+   string err;
+
+   const llvm::Target* target = llvm::TargetRegistry::lookupTarget(triple, err);
+
+   if (!target)
+   {
+      Log::log_error(Error(0, 0, string("No target for '" + triple + "': " + err)));
+
+      return false;
+   }
+
+   string cpuName;
+   string features;
+
+   resolve_cpu(cpu, cpuName, features);
+
+   machine.reset(target->createTargetMachine(triple, cpuName, features,
+					     llvm::TargetOptions(),
+					     llvm::Reloc::PIC_,
+					     llvm::None,
+					     levels[std::min(level, 3u)]));
+
+   //(LLVM only warns about a CPU it doesn't know, then fails in codegen)
+   if (!machine ||
+       (!cpuName.empty() && !machine->getMCSubtargetInfo()->isCPUStringValid(cpuName)))
+   {
+      Log::log_error(Error(0, 0, string("Couldn't target CPU '" + cpuName + "'.")));
+
+      return false;
+   }
+
+   module->setTargetTriple(triple);
+   module->setDataLayout(machine->createDataLayout());
+
+   jitTarget = false;
+   targetCPU = cpu;
+   targetLevel = level;
+
+   return true;
+}
+
+bool
+ParseBuild::SetJITTarget()
+{
+   llvm::InitializeNativeTarget();
+   llvm::InitializeNativeTargetAsmPrinter();
+
+   //As LLJIT itself does, unless told otherwise
+   llvm::Expected<llvm::orc::JITTargetMachineBuilder> host =
+      llvm::orc::JITTargetMachineBuilder::detectHost();
+
+   llvm::Expected<unique_ptr<llvm::TargetMachine>> created =
+      host ? host->createTargetMachine() : host.takeError();
+
+   if (!created)
+   {
+      Log::log_error(Error(0, 0, string("Couldn't target the JIT: " +
+					llvm::toString(created.takeError()))));
+      return false;
+   }
+
+   machine = std::move(*created);
+
+   module->setTargetTriple(machine->getTargetTriple().str());
+   module->setDataLayout(machine->createDataLayout());
+
+   jitTarget = true;
+
+   return true;
+}
+
+bool
+ParseBuild::SetTargetAs(const ParseBuild& other)
+{
+   if (!other.machine)
+      return true;
+
+   return other.jitTarget ? SetJITTarget() : SetTarget(other.targetCPU, other.targetLevel);
+}
+
+bool
+ParseBuild::write_file(const string& path, llvm::StringRef data, bool text)
+{
+   std::error_code ec;
+   llvm::raw_fd_ostream out(path, ec, text ? llvm::sys::fs::OF_Text : llvm::sys::fs::OF_None);
+
+   if (ec)
+   {
+      Log::log_error(Error(0, 0, string("Couldn't open '" + path + "': " + ec.message())));
+
+      return false;
+   }
+
+   out << data;
+
+   return true;
+}
+
+bool
+ParseBuild::Emit(const string& path, bool assembly, llvm::ObjectCache* cache)
+{
+   if (!machine)
+      return false;
+
+   //Written to memory first, so the cache can have it too
+   llvm::SmallVector<char, 0> emitted;
+   llvm::raw_svector_ostream out(emitted);
+
+   //Codegen is still on the legacy pass manager
+   llvm::legacy::PassManager codegen;
+
+   if (machine->addPassesToEmitFile(codegen, out, nullptr,
+				    assembly ? llvm::CGFT_AssemblyFile : llvm::CGFT_ObjectFile))
+   {
+      Log::log_error(Error(0, 0, string("The target can't write that kind of file.")));
+
+      return false;
+   }
+
+   codegen.run(*module);
+
+   if (cache && !assembly)
+      cache->notifyObjectCompiled(module.get(), llvm::MemoryBufferRef(out.str(), path));
+
+   return write_file(path, out.str(), assembly);
+}
+
+bool
+ParseBuild::EmitIR(const string& path, bool bitcode)
+{
+   std::error_code ec;
+   llvm::raw_fd_ostream out(path, ec,
+			    bitcode ? llvm::sys::fs::OF_None : llvm::sys::fs::OF_Text);
+
+   if (ec)
+   {
+      Log::log_error(Error(0, 0, string("Couldn't open '" + path + "': " + ec.message())));
+
+      return false;
+   }
+
+   if (bitcode)
+      llvm::WriteBitcodeToFile(*module, out);
+
+   else module->print(out, nullptr);
+
+   return true;
+}
+
+void
+ParseBuild::BuildRunner(llvm::Function* entry)
+{
+   llvm::StructType* rets = llvm::dyn_cast<llvm::StructType>(entry->getReturnType());
+
+   llvm::Function* runner = llvm::Function::Create(llvm::FunctionType::get(builder.getVoidTy(),
+									  {builder.getInt8PtrTy()},
+									  false),
+						   llvm::Function::ExternalLinkage,
+						   "adze.run",
+						   module.get());
+
+   builder.SetInsertPoint(llvm::BasicBlock::Create(*context, "entry", runner));
+
+   llvm::Value* result = builder.CreateCall(entry);
+
+   //Size of out, number of values, then each value's offset (shifted
+   //up one) | whether it's a float
+   vector<uint64_t> layout = {0, 0};
+
+   if (rets)
+   {
+      builder.CreateStore(result, builder.CreateBitCast(runner->getArg(0),
+							rets->getPointerTo()));
+
+      const llvm::StructLayout* sl = module->getDataLayout().getStructLayout(rets);
+
+      layout[0] = sl->getSizeInBytes();
+      layout[1] = rets->getNumElements();
+
+      for (unsigned i = 0; i < rets->getNumElements(); ++i)
+	 layout.push_back((sl->getElementOffset(i) << 1) |
+			  rets->getElementType(i)->isFloatTy());
+   }
+
+   builder.CreateRetVoid();
+
+   llvm::Constant* values = llvm::ConstantDataArray::get(*context, llvm::ArrayRef<uint64_t>(layout));
+
+   new llvm::GlobalVariable(*module, values->getType(), true,
+			    llvm::GlobalValue::ExternalLinkage, values,
+			    "adze.run.values");
+}
+
+llvm::Error
+ParseBuild::link_process(llvm::orc::LLJIT& jit)
+{
+   llvm::Expected<unique_ptr<llvm::orc::DynamicLibrarySearchGenerator>> process =
+      llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(jit.getDataLayout().getGlobalPrefix());
+
+   if (!process)
+      return process.takeError();
+
+   jit.getMainJITDylib().addGenerator(std::move(*process));
+
+   return llvm::Error::success();
+}
+
+llvm::Error
+ParseBuild::run_entry(llvm::orc::LLJIT& jit, std::ostream& out)
+{
+   llvm::Expected<llvm::JITEvaluatedSymbol> runner = jit.lookup("adze.run");
+
+   if (!runner)
+      return runner.takeError();
+
+   llvm::Expected<llvm::JITEvaluatedSymbol> values = jit.lookup("adze.run.values");
+
+   if (!values)
+      return values.takeError();
+
+   const uint64_t* layout = (const uint64_t*) values->getAddress();
+
+   vector<uint64_t> buffer(layout[0] / sizeof(uint64_t) + 1);
+
+   auto run = (void (*)(void*)) runner->getAddress();
+
+   run(buffer.data());
+
+   for (uint64_t i = 0; i < layout[1]; ++i)
+   {
+      const char* at = (const char*) buffer.data() + (layout[2 + i] >> 1);
+
+      if (layout[2 + i] & 1)
+	 out << *(const float*) at << endl;
+
+      else out << *(const int32_t*) at << endl;
+   }
+
+   return llvm::Error::success();
+}
+
+bool
+ParseBuild::Run(const string& entry, std::ostream& out, llvm::ObjectCache* cache)
+{
+   llvm::Function* func = module->getFunction(entry);
+
+   if (!func || func->isDeclaration())
+   {
+      Log::log_error(Error(0, 0, string("No function '" + entry + "' to run.")));
+
+      return false;
+   }
+
+   if (func->arg_size())
+   {
+      Log::log_error(Error(0, 0, string("Can't run '" + entry + "'; it takes params.")));
+
+      return false;
+   }
+
+   //Not laid out for it yet, and not optimised either then
+   if (!jitTarget && !SetJITTarget())
+      return false;
+
+   llvm::orc::LLJITBuilder jitBuilder;
+
+   //The cache gets the object once it's compiled
+   if (cache)
+   {
+      jitBuilder.setCompileFunctionCreator([cache] (llvm::orc::JITTargetMachineBuilder jtmb)
+	 -> llvm::Expected<unique_ptr<llvm::orc::IRCompileLayer::IRCompiler>>
+      {
+	 return std::make_unique<llvm::orc::ConcurrentIRCompiler>(std::move(jtmb), cache);
+      });
+   }
+
+   llvm::Expected<unique_ptr<llvm::orc::LLJIT>> jit = jitBuilder.create();
+
+   if (!jit)
+   {
+      Log::log_error(Error(0, 0, string("Couldn't start the JIT: " +
+					llvm::toString(jit.takeError()))));
+      return false;
+   }
+
+   BuildRunner(func);
+
+   llvm::Error err = link_process(**jit);
+
+   if (!err)
+      err = (*jit)->addIRModule(llvm::orc::ThreadSafeModule(std::move(module),
+							    std::move(context)));
+   if (!err)
+      err = run_entry(**jit, out);
+
+   if (err)
+   {
+      Log::log_error(Error(0, 0, string("Couldn't run '" + entry + "': " +
+					llvm::toString(std::move(err)))));
+      return false;
+   }
+
+   return true;
+}
+
+bool
+ParseBuild::RunObject(unique_ptr<llvm::MemoryBuffer> obj, const string& entry, std::ostream& out)
+{
+   llvm::InitializeNativeTarget();
+   llvm::InitializeNativeTargetAsmPrinter();
+
+   llvm::Expected<unique_ptr<llvm::orc::LLJIT>> jit = llvm::orc::LLJITBuilder().create();
+
+   llvm::Error err = jit ? link_process(**jit) : jit.takeError();
+
+   if (!err)
+      err = (*jit)->addObjectFile(std::move(obj));
+
+   if (!err)
+      err = run_entry(**jit, out);
+
+   if (err)
+   {
+      Log::log_error(Error(0, 0, string("Couldn't run '" + entry + "': " +
+					llvm::toString(std::move(err)))));
+      return false;
+   }
+
+   return true;
+}
@@ -6,8 +6,22 @@
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetMachine.h"
 
 #include "ParseScope.hpp"
+#include "SSABuilder.hpp"
+
+#include <functional>
+
+namespace llvm
+{
+   class ObjectCache;
+
+   namespace orc { class LLJIT; }
+}
 
 class ParseBuild
 /*
@@ -15,15 +29,56 @@ class ParseBuild
 */
 {
 private:
-   llvm::LLVMContext context;
+   //Held by pointer so it can be handed on with the module (see Run())
+   unique_ptr<llvm::LLVMContext> context;
    llvm::IRBuilder<> builder;
    unique_ptr<llvm::Module> module;
 
+   //Function table, indexed by symbol of the function name; nullptr
+   //where there's no such function (yet)
+   vector<llvm::Function*> functions;
+
+   //For functions called but not in the table; see SetDeclarer()
+   std::function<llvm::Function*(symbol)> declarer;
+
+   //What to generate machine code for; nullptr until SetTarget() or
+   //SetJITTarget()
+   unique_ptr<llvm::TargetMachine> machine;
+   bool jitTarget; //If it's the JIT's (see SetJITTarget())
+   //Otherwise what SetTarget() was given, for SetTargetAs()
+   string targetCPU;
+   unsigned targetLevel;
+
+   //Where things like verifier failures are written
+   llvm::raw_ostream* diagnostics;
+
+   //Locals as SSA values rather than allocas, if ssa (see SetSSA())
+   bool ssa;
+   SSABuilder vars;
+
+   bool fastMath; //See SetFastMath()
+
+   //For each loop's metadata; 0 for LLVM to decide (see SetLoopHints())
+   unsigned vectorizeWidth;
+   unsigned unrollCount;
+
+   //Function's entry block, where allocas go (wherever generation's
+   //got to)
+   llvm::BasicBlock* allocBlock;
+
    //Insertion point after last alloc in this block
    //(actually, it's one before that- see .cpp)
    llvm::BasicBlock::iterator allocInsert;
    
 public:
+   //Size of the module, for comparing before and after passes
+   struct stats
+   {
+      size_t functions; //Defined, not just declared
+      size_t blocks;
+      size_t instructions;
+      size_t bitcode; //Bytes, written out
+   };
 
    ParseBuild();
    /*
@@ -34,10 +89,138 @@ public:
    llvm::LLVMContext& GetContext();
    llvm::IRBuilder<>& GetBuilder();
    unique_ptr<llvm::Module>& GetModule();
+   //For handing on with the module, after which this is done with
+   unique_ptr<llvm::LLVMContext> TakeContext();
+
+   //llvm::errs() unless set otherwise
+   llvm::raw_ostream& GetDiagnostics();
+   void SetDiagnostics(llvm::raw_ostream& os);
 
    llvm::AllocaInst* allocate_instruction(ParseScope& scope,
-					  llvm::Type* typ, const string& nam);
+					  llvm::Type* typ,
+					  symbol sym, llvm::StringRef nam);
+
+   /*
+     Build locals (params included) as SSA values directly, rather
+     than loading and storing allocas; see SSABuilder. Off unless set.
+     Either way a variable is an AllocaInst in scope, so the rest of
+     generation goes through these rather than loading and storing it
+     itself.
+   */
+   void SetSSA(bool on);
+   bool IsSSA() const;
+   /*
+     Let float math be done fast rather than exactly as written: every
+     float op generated gets LLVM's fast-math flags (reassociation,
+     no NaNs or infinities, and so on), and every function the
+     matching attributes, so codegen can do the same. This is what
+     lets sums be reassociated and vectorised. Off unless set.
+   */
+   void SetFastMath(bool on);
+   bool IsFastMath() const;
+
+   /*
+     What each loop generated is marked as wanting, for LoopVectorize
+     (llvm.loop.vectorize.width) and LoopUnroll (llvm.loop.unroll.count).
+     0 leaves it to them, and if both are, loops have no metadata.
+   */
+   void SetLoopHints(unsigned width, unsigned unroll);
+   //The metadata for a loop's latch branch, or nullptr; a new node
+   //each time, as each loop needs its own
+   llvm::MDNode* MakeLoopID();
+
+   //A new block at the end of the function being generated; and go
+   //on generating at the end of one
+   llvm::BasicBlock* NewBlock(const llvm::Twine& name);
+   void SetBlock(llvm::BasicBlock* block);
+   //Every branch to block has been generated (only matters for SSA;
+   //see SSABuilder::Seal())
+   void SealBlock(llvm::BasicBlock* block);
+
+   //A new variable, in scope: an alloca, or one of SSABuilder's
+   llvm::AllocaInst* declare_variable(ParseScope& scope,
+				      llvm::Type* typ,
+				      symbol sym, llvm::StringRef nam);
+   //Its value here, or set it here
+   llvm::Value* ReadVariable(llvm::AllocaInst* var, llvm::StringRef nam);
+   llvm::Value* WriteVariable(llvm::AllocaInst* var, llvm::Value* val);
+
+   llvm::Function* GetFunction(symbol name) const;
+   void AddFunction(symbol name, llvm::Function* func);
+   //A function being called: as GetFunction(), but if it's not there
+   //the declarer (if set) gets a chance to declare it
+   llvm::Function* GetCallee(symbol name);
+   void SetDeclarer(std::function<llvm::Function*(symbol)> decl);
 
    //Advantage of having this here is it can initialise allocInsert
    void BuildFunction(ParseScope& scope, llvm::Function* func);
+   //After its statements
+   void FinishFunction();
+
+   //Run LLVM's standard (new pass manager) pipeline for -O<level>,
+   //0 to 3, over the whole module
+   void Optimise(unsigned level);
+   stats GetStats() const;
+
+   /*
+     Target the host, as cpu (a name like "skylake", "native" for
+     this one and its features, or "" for a generic one), with codegen
+     at -O<level>. Sets the module's triple and data layout, so do
+     it before Optimise(), which then knows the target too; false if
+     there's no such target.
+   */
+   bool SetTarget(const string& cpu, unsigned level);
+   //Target what Run()'s JIT compiles for (this machine), likewise
+   //before Optimise(), so that what's optimised is laid out as it'll
+   //be run. False if it can't be
+   bool SetJITTarget();
+   //Target whatever 'other' was told to (if anything), with a
+   //TargetMachine of this one's own. False if it can't be
+   bool SetTargetAs(const ParseBuild& other);
+   //The name and features SetTarget() would use for cpu
+   static void resolve_cpu(const string& cpu, string& name, string& features);
+   //Triple, name and features, as one string; for telling targets apart
+   static string describe_target(const string& cpu);
+
+   //Write an object file (or assembly) for the target; false if it
+   //couldn't be. An object file also goes to 'cache', if there is one
+   bool Emit(const string& path, bool assembly, llvm::ObjectCache* cache);
+   //Write data to path; false (logged) if it couldn't be
+   static bool write_file(const string& path, llvm::StringRef data, bool text);
+
+   //Write the module as bitcode, or as text IR; false if it couldn't
+   //be
+   bool EmitIR(const string& path, bool bitcode);
+
+   /*
+     Functions return a struct of their return values by value (see
+     generate_signature()), and how that's passed back depends on the
+     platform. So rather than being called directly, 'entry' (taking
+     no params) is called through adze.run(i8* out), added to the
+     module here, which stores the struct to out.
+     Where each value will be in out, going by the module's data
+     layout (so set that first), goes in the module too, as
+     adze.run.values, so that a compiled object can be run on its own.
+   */
+   void BuildRunner(llvm::Function* entry);
+   //Let what's run in 'jit' call into this process's libraries, like
+   //libm's fmodf() and powf(), which float ops can come out as
+   static llvm::Error link_process(llvm::orc::LLJIT& jit);
+   //Call adze.run() in 'jit', writing the values it leaves to 'out',
+   //one a line
+   static llvm::Error run_entry(llvm::orc::LLJIT& jit, std::ostream& out);
+
+   /*
+     JIT the module and call 'entry' (which takes no params) in this
+     process, writing what it returns to 'out', one value a line. The
+     object compiled goes to 'cache', if there is one.
+     The module and context go to the JIT, so nothing more can be done
+     with this afterwards. False if it couldn't be run.
+     Targets the JIT first, if SetJITTarget() hasn't been.
+   */
+   bool Run(const string& entry, std::ostream& out, llvm::ObjectCache* cache);
+   //The same for an object Run() compiled before (one with 'entry's
+   //adze.run() in it)
+   static bool RunObject(unique_ptr<llvm::MemoryBuffer> obj, const string& entry,
+			 std::ostream& out);
 };
@@ -0,0 +1,544 @@
+#include "ParseFold.hpp"
+
+//Fold()s of each Expression are here, as their Flatten()s are in
+//FlatTree.cpp
+#include "exprs/subexprs/VarExpression.hpp"
+#include "exprs/subexprs/LitIntExpression.hpp"
+#include "exprs/subexprs/BinaryExpression.hpp"
+#include "exprs/subexprs/CallExpression.hpp"
+#include "exprs/subexprs/ReturnExpression.hpp"
+#include "exprs/subexprs/FunctionExpression.hpp"
+#include "exprs/subexprs/SignatureExpression.hpp"
+#include "exprs/subexprs/AssignExpression.hpp"
+#include "exprs/subexprs/InitVarExpression.hpp"
+#include "exprs/subexprs/LoopExpression.hpp"
+
+#include "llvm/Support/MathExtras.h"
+
+#include <algorithm>
+#include <climits>
+
+using namespace std;
+
+ParseFold::ParseFold(ParseArena& ar)
+   : arena (ar)
+   , nodes (0)
+   , removed (0)
+   , added (0)
+{
+}
+
+ParseArena&
+ParseFold::GetArena()
+{
+   return arena;
+}
+
+ParseFold::var_state&
+ParseFold::state(symbol name)
+{
+   if (name >= states.size())
+   {
+      states.resize(name + 1, var_state::UNKNOWN);
+      values.resize(name + 1, 0);
+   }
+
+   return states[name];
+}
+
+void
+ParseFold::BeginFunction()
+{
+   for (symbol name : touched)
+      states[name] = var_state::UNKNOWN;
+
+   touched.clear();
+}
+
+void
+ParseFold::Declare(symbol name, bool isInt)
+{
+   if (!isInt)
+   {
+      state(name) = var_state::UNKNOWN;
+
+      return;
+   }
+
+   state(name) = var_state::DECLARED;
+   touched.push_back(name);
+}
+
+void
+ParseFold::Set(symbol name, int value)
+{
+   //Only locals declared in this function; anything else is left for
+   //generation to complain about
+   var_state& st = state(name);
+
+   if (st == var_state::UNKNOWN)
+      return;
+
+   st = var_state::CONSTANT;
+   values[name] = value;
+}
+
+void
+ParseFold::Forget(symbol name)
+{
+   var_state& st = state(name);
+
+   if (st == var_state::CONSTANT)
+      st = var_state::DECLARED;
+}
+
+void
+ParseFold::ForgetValues()
+{
+   for (symbol name : touched)
+   {
+      if (states[name] == var_state::CONSTANT)
+	 states[name] = var_state::DECLARED;
+   }
+}
+
+bool
+ParseFold::Get(symbol name, int& value) const
+{
+   if ((name >= states.size()) || (states[name] != var_state::CONSTANT))
+      return false;
+
+   value = values[name];
+
+   return true;
+}
+
+bool
+ParseFold::IsInt(symbol name) const
+{
+   return (name < states.size()) && (states[name] != var_state::UNKNOWN);
+}
+
+void
+ParseFold::Count()
+{
+   ++nodes;
+}
+
+void
+ParseFold::Replaced(size_t rem, size_t add)
+{
+   removed += rem;
+   added += add;
+}
+
+size_t
+ParseFold::NodesBefore() const
+{
+   return nodes;
+}
+
+size_t
+ParseFold::NodesAfter() const
+{
+   return nodes + added - removed;
+}
+
+//a ^ b, as generated (see generate_exp() in generator.cpp)
+static int
+int_pow(int a, int b)
+{
+   if (b < 0)
+   {
+      if (a == 1)
+	 return 1;
+
+      if (a == -1)
+	 return (b & 1) ? -1 : 1;
+
+      return 0;
+   }
+
+   uint32_t result = 1;
+   uint32_t base = (uint32_t) a;
+
+   for (uint32_t e = (uint32_t) b; e; e >>= 1)
+   {
+      if (e & 1)
+	 result *= base;
+
+      base *= base;
+   }
+
+   return (int) result;
+}
+
+//n ¬/ x, as generated (see generate_root() in generator.cpp)
+static int
+int_root(int n, int x)
+{
+   if (n < 1)
+      return 0;
+
+   if (n == 1)
+      return x;
+
+   bool neg = x < 0;
+
+   if (neg && !(n & 1))
+      return 0;
+
+   int64_t mag = neg ? -(int64_t) x : (int64_t) x;
+   int64_t lo = 0;
+   int64_t hi = std::min<int64_t>(mag, 46340) + 1;
+
+   while (hi - lo > 1)
+   {
+      int64_t mid = (lo + hi) / 2;
+      int64_t p = 1;
+
+      for (int i = 0; (i < n) && (p <= mag) && (mid > 1); ++i)
+	 p *= mid;
+
+      if (p <= mag)
+	 lo = mid;
+
+      else hi = mid;
+   }
+
+   return neg ? -(int) lo : (int) lo;
+}
+
+/*
+  l op r, as generate_binary() would work it out at run time (ints are
+  i32, wrapping); false if it can't be done here, for ops that aren't
+  folded, or where it would be undefined (left for run time, as it
+  was).
+*/
+static bool
+fold_ints(token_kind op, int l, int r, int& result)
+{
+   uint32_t ul = (uint32_t) l;
+   uint32_t ur = (uint32_t) r;
+
+   switch (op)
+   {
+      case token_kind::OP_ADD:
+	 result = (int) (ul + ur);
+	 return true;
+
+      case token_kind::OP_SUB:
+	 result = (int) (ul - ur);
+	 return true;
+
+      case token_kind::OP_MUL:
+	 result = (int) (ul * ur);
+	 return true;
+
+      case token_kind::OP_DIV:
+	 if (!r || ((l == INT_MIN) && (r == -1)))
+	    return false;
+
+	 result = l / r;
+	 return true;
+
+      case token_kind::OP_MOD:
+	 //Unsigned, as generated (see generate_binary())
+	 if (!r)
+	    return false;
+
+	 result = (int) (ul % ur);
+	 return true;
+
+      case token_kind::OP_EXP:
+	 result = int_pow(l, r);
+	 return true;
+
+      case token_kind::OP_ROOT:
+	 result = int_root(l, r);
+	 return true;
+
+      //Bools, which are 0 or 1 as ints anyway
+      case token_kind::OP_LT:
+	 result = l < r;
+	 return true;
+
+      case token_kind::OP_GT:
+	 result = l > r;
+	 return true;
+
+      case token_kind::OP_LE:
+	 result = l <= r;
+	 return true;
+
+      case token_kind::OP_GE:
+	 result = l >= r;
+	 return true;
+
+      case token_kind::OP_EQ:
+	 result = l == r;
+	 return true;
+
+      case token_kind::OP_NE:
+	 result = l != r;
+	 return true;
+
+      default:
+	 return false;
+   }
+}
+
+//
+
+Expression*
+BinaryExpression::Fold(ParseFold& fold)
+{
+   fold.Count();
+
+   lhs = lhs->Fold(fold);
+   rhs = rhs->Fold(fold);
+
+   int l;
+   int r;
+   bool lLit = lhs->GetLitInt(l);
+   bool rLit = rhs->GetLitInt(r);
+
+   if (lLit && rLit)
+   {
+      int result;
+
+      if (fold_ints(op, l, r, result))
+      {
+	 fold.Replaced(3, 1);
+
+	 return fold.GetArena().make<LitIntExpression>(result);
+      }
+
+      return this;
+   }
+
+   //Identities: just the other side, dropping this and the literal.
+   //(Adding 0 only to an int: a float -0.0 would come out +0.0)
+   if (rLit &&
+       (((op == token_kind::OP_ADD) && (r == 0) && lhs->IsInt(fold)) ||
+	((op == token_kind::OP_SUB) && (r == 0)) ||
+	(((op == token_kind::OP_MUL) || (op == token_kind::OP_DIV)) && (r == 1))))
+   {
+      fold.Replaced(2, 0);
+
+      return lhs;
+   }
+
+   if (lLit &&
+       (((op == token_kind::OP_ADD) && (l == 0) && rhs->IsInt(fold)) ||
+	((op == token_kind::OP_MUL) && (l == 1))))
+   {
+      fold.Replaced(2, 0);
+
+      return rhs;
+   }
+
+   //Multiplying an int by 2^k is shifting it left by k, wrapping just
+   //the same. (Not a float, which codegen can't shift)
+   if ((op == token_kind::OP_MUL) && lLit && !rLit)
+   {
+      swap(lhs, rhs);
+      swap(l, r);
+      swap(lLit, rLit);
+   }
+
+   if ((op == token_kind::OP_MUL) && rLit && (r > 1) && llvm::isPowerOf2_32(r) && lhs->IsInt(fold))
+   {
+      op = token_kind::OP_SHL;
+      rhs = fold.GetArena().make<LitIntExpression>((int) llvm::Log2_32(r));
+
+      fold.Replaced(1, 1);
+   }
+
+   return this;
+}
+
+bool
+BinaryExpression::IsInt(const ParseFold& fold) const
+{
+   switch (op)
+   {
+      //Comparisons make bools, which are ints 0 or 1 to anything else
+      case token_kind::OP_LT:
+      case token_kind::OP_GT:
+      case token_kind::OP_LE:
+      case token_kind::OP_GE:
+      case token_kind::OP_EQ:
+      case token_kind::OP_NE:
+	 return true;
+
+      //Any other op of two ints makes an int
+      default:
+	 return lhs->IsInt(fold) && rhs->IsInt(fold);
+   }
+}
+
+Expression*
+LitIntExpression::Fold(ParseFold& fold)
+{
+   fold.Count();
+
+   return this;
+}
+
+bool
+LitIntExpression::GetLitInt(int& val) const
+{
+   val = value;
+
+   return true;
+}
+
+bool
+LitIntExpression::IsInt(const ParseFold& fold) const
+{
+   return true;
+}
+
+Expression*
+VarExpression::Fold(ParseFold& fold)
+{
+   fold.Count();
+
+   int value;
+
+   if (!fold.Get(varName, value))
+      return this;
+
+   fold.Replaced(1, 1);
+
+   return fold.GetArena().make<LitIntExpression>(value);
+}
+
+Expression*
+VarExpression::FoldLHS(ParseFold& fold)
+{
+   //Assigned to, not read
+   fold.Count();
+
+   return this;
+}
+
+bool
+VarExpression::IsInt(const ParseFold& fold) const
+{
+   return fold.IsInt(varName);
+}
+
+Expression*
+InitVarExpression::Fold(ParseFold& fold)
+{
+   fold.Count();
+
+   fold.Declare(varName, Interner::builtin_kind(typName) == token_kind::TYPE_INT);
+
+   return this;
+}
+
+Expression*
+AssignExpression::Fold(ParseFold& fold)
+{
+   fold.Count();
+
+   //lhs first, as it's generated, in case it's an init
+   lhs = lhs->FoldLHS(fold);
+   rhs = rhs->Fold(fold);
+
+   symbol name = lhs->GetSubject();
+   int value;
+
+   if (rhs->GetLitInt(value))
+      fold.Set(name, value);
+
+   else fold.Forget(name);
+
+   return this;
+}
+
+//Fold each of a list of children, copying it into the arena again
+//only if any changed
+static llvm::ArrayRef<Expression*>
+fold_list(ParseFold& fold, llvm::ArrayRef<Expression*> exprs)
+{
+   llvm::SmallVector<Expression*, 16> folded;
+   bool changed = false;
+
+   for (Expression* expr : exprs)
+   {
+      folded.push_back(expr->Fold(fold));
+
+      changed |= (folded.back() != expr);
+   }
+
+   if (!changed)
+      return exprs;
+
+   return fold.GetArena().copy(llvm::ArrayRef<Expression*>(folded));
+}
+
+Expression*
+CallExpression::Fold(ParseFold& fold)
+{
+   fold.Count();
+
+   args = fold_list(fold, args);
+
+   return this;
+}
+
+Expression*
+ReturnExpression::Fold(ParseFold& fold)
+{
+   fold.Count();
+
+   rets = fold_list(fold, rets);
+
+   return this;
+}
+
+Expression*
+FunctionExpression::Fold(ParseFold& fold)
+{
+   fold.Count();
+
+   signature = signature->Fold(fold);
+
+   fold.BeginFunction();
+
+   //Params are locals like any other, just not assigned a literal
+   for (const tuple<symbol, symbol>& param : static_cast<SignatureExpression*>(signature)->GetParams())
+      fold.Declare(get<1>(param), Interner::builtin_kind(get<0>(param)) == token_kind::TYPE_INT);
+
+   statements = fold_list(fold, statements);
+
+   return this;
+}
+
+Expression*
+LoopExpression::Fold(ParseFold& fold)
+{
+   fold.Count();
+
+   if (init)
+      init = init->Fold(fold);
+
+   //Whatever the loop changes might be anything by the time the
+   //condition's checked again
+   fold.ForgetValues();
+
+   cond = cond->Fold(fold);
+   body = fold_list(fold, body);
+
+   if (step)
+      step = step->Fold(fold);
+
+   //And after it, whatever it went round (if at all)
+   fold.ForgetValues();
+
+   return this;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Interner.hpp"
+#include "ParseArena.hpp"
+
+#include <cstdint>
+#include <vector>
+
+class ParseFold
+/*
+  State for folding the parsed tree before it's generated
+  (Expression::Fold()): literal subtrees are worked out, identities
+  like x * 1 and x + 0 (for ints; for floats it isn't one, as
+  -0.0 + 0 is +0.0) dropped, multiplies by powers of 2 made shifts,
+  and ints known to hold a constant are replaced by it where they're
+  read.
+
+  What's known is only ever of int locals (params included) assigned a
+  (folded) literal, and is forgotten at the start of each function.
+  Loops are the only control flow: everything known is forgotten on
+  the way into one (its condition and body see what the last time
+  round left, not just what came before) and on the way out (it may
+  have gone round any number of times).
+
+  It also counts nodes, to say how much smaller the tree got.
+*/
+{
+private:
+   ParseArena& arena; //For new nodes
+
+   enum class var_state : uint8_t
+   {
+      UNKNOWN, //Not a local int of this function, or not folded
+      DECLARED, //A local int, value unknown
+      CONSTANT
+   };
+
+   //By symbol of the variable's name; and which have been set, to
+   //clear them for the next function
+   std::vector<var_state> states;
+   std::vector<int> values;
+   std::vector<symbol> touched;
+
+   size_t nodes; //Folded, ie in the tree before
+   size_t removed;
+   size_t added;
+
+   var_state& state(symbol name);
+
+public:
+   ParseFold(ParseArena& ar);
+
+   ParseArena& GetArena();
+
+   //Forget everything about the last function's variables
+   void BeginFunction();
+
+   //A new local: known of if it's an int, whose value is known once
+   //it's assigned one. Forgotten about otherwise
+   void Declare(symbol name, bool isInt);
+   //Assigned a literal, or something else
+   void Set(symbol name, int value);
+   void Forget(symbol name);
+   //Forget every value, though not which are ints
+   void ForgetValues();
+   //If its value is known
+   bool Get(symbol name, int& value) const;
+   //If it's a local int (of known value or not)
+   bool IsInt(symbol name) const;
+
+   //Each node folded counts itself; and each that replaces some with
+   //others says how many
+   void Count();
+   void Replaced(size_t rem, size_t add);
+
+   size_t NodesBefore() const;
+   size_t NodesAfter() const;
+};
@@ -1,17 +1,35 @@
 #include "ParseInfo.hpp"
 
-const std::map<token_kind, int> ParseInfo::precedences =
-{{token_kind::OP_ADD, 8},
- {token_kind::OP_SUB, 7},
- {token_kind::OP_MUL, 9},
- {token_kind::OP_DIV, 11},
- {token_kind::OP_MOD, 10},
- {token_kind::OP_EXP, 13},
- {token_kind::OP_ROOT, 12}};
-
-ParseInfo::ParseInfo(ParseBuild& build)
+#include "llvm/ADT/APFloat.h"
+
+ParseInfo::ParseInfo(ParseBuild& build, Interner& nms, ParseArena& ar)
    : context (build.GetContext())
+   , names (nms)
+   , arena (ar)
+   , kindTypes {}
+{
+   kindTypes[(size_t) token_kind::TYPE_INT] = llvm::Type::getInt32Ty(context);
+   kindTypes[(size_t) token_kind::TYPE_FLOAT] = llvm::Type::getFloatTy(context);
+   //TODO string
+
+   //Only primitives for now, whose symbols are fixed
+   //TODO custom types
+   types.resize(Interner::builtin_end());
+
+   for (symbol sym = 0; sym < types.size(); ++sym)
+      types[sym] = GetType(Interner::builtin_kind(sym));
+}
+
+Interner&
+ParseInfo::GetNames() const
 {
+   return names;
+}
+
+ParseArena&
+ParseInfo::GetArena() const
+{
+   return arena;
 }
 
 bool
@@ -22,8 +40,6 @@ ParseInfo::get_literal_int(const std::string& str,
    //as it is, might be that there are more stringent requirements
    //for ints in adze than in C++.
 
-   //TODO: Check over size? Note that stoi might throw out_of_range exception.
-
    //First char can be -
    if (str[0] == '-')
    {
@@ -43,23 +59,58 @@ ParseInfo::get_literal_int(const std::string& str,
       }
    }
 
-   result = std::stoi(str);
+   //Too big for an int isn't valid either. (Not stoi(), which would
+   //throw, and exceptions are off.)
+   return !llvm::StringRef(str).getAsInteger(10, result);
+}
+
+bool
+ParseInfo::get_literal_float(const std::string& str,
+			     float& result)
+{
+   //The lexer has already checked it's digits with a point in (and
+   //maybe a -); rounded to the nearest float, as C++ would
+   llvm::APFloat value(llvm::APFloat::IEEEsingle());
+   llvm::Expected<llvm::APFloat::opStatus> status =
+      value.convertFromString(str, llvm::APFloat::rmNearestTiesToEven);
+
+   if (!status)
+   {
+      llvm::consumeError(status.takeError());
+
+      return false;
+   }
+
+   //Too big for a float
+   if (*status & llvm::APFloat::opOverflow)
+      return false;
+
+   result = value.convertToFloat();
 
-   return false;
+   return true;
 }
 
 int
 ParseInfo::get_binary_precedence(const token& tok) const
 {
-   if (precedences.count(tok.GetKind()))
-      return precedences.at(tok.GetKind());
+   return get_binary_precedence(tok.GetKind());
+}
+
+int
+ParseInfo::get_binary_precedence(token_kind kind) const
+{
+   return binary_ops.ops[(size_t) kind].precedence;
+}
 
-   else return 0;
+const binary_op&
+ParseInfo::get_binary_op(token_kind kind) const
+{
+   return binary_ops.ops[(size_t) kind];
 }
 
 
 bool
-ParseInfo::is_valid_func_name(const std::string& str) const
+ParseInfo::is_valid_func_name(llvm::StringRef str) const
 {
    //TODO
 
@@ -67,7 +118,7 @@ ParseInfo::is_valid_func_name(const std::string& str) const
 }
 
 bool
-ParseInfo::is_valid_type_name(const std::string& str) const
+ParseInfo::is_valid_type_name(llvm::StringRef str) const
 {
    //TODO
       
@@ -138,54 +189,22 @@ ParseInfo::is_rhs_end(const token_kind& tok) const
 }
 
 llvm::Type*
-ParseInfo::GetType(const std::string str)
+ParseInfo::GetType(symbol typ) const
 {
-   llvm::Type* ty = nullptr;
-
-   if (str == "int")
-      ty = llvm::Type::getInt32Ty(context);
-
-   else if (str == "float")
-      ty = llvm::Type::getFloatTy(context);
-
-   else if (str == "string")
-   {
-      //uhhhh - TODO
-   }
-
-   return ty;
+   return (typ < types.size()) ? types[typ] : nullptr;
 }
 
 llvm::Type*
-ParseInfo::GetType(const token_kind tok)
+ParseInfo::GetType(const token_kind tok) const
 {
-   switch (tok)
-   {
-      case token_kind::TYPE_INT:
-	 return llvm::Type::getInt32Ty(context);
-
-      case token_kind::TYPE_FLOAT:
-	 return llvm::Type::getFloatTy(context);
-
-	 //TODO string
-
-      default:
-	 return nullptr;
-   }
+   return kindTypes[(size_t) tok];
 }
 
 size_t
-ParseInfo::GetTypeSize(const std::string& str) const
+ParseInfo::GetTypeSize(symbol typ) const
 {
-   if (str == "int")
-      return 32;
-
-   else if (str == "float")
-      return 32;
-
-   else if (str == "string")
-      //TODO
-      return 0;
+   //TODO string
+   llvm::Type* type = GetType(typ);
 
-   else return 0;
+   return type ? type->getPrimitiveSizeInBits() : 0;
 }
@@ -3,43 +3,102 @@
 #include "lexer.hpp"
 
 #include "ParseBuild.hpp"
+#include "Interner.hpp"
+#include "ParseArena.hpp"
 
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Type.h"
 
+#include <array>
 #include <string>
-#include <map>
+#include <vector>
+
+const size_t n_token_kinds = (size_t) token_kind::END + 1;
+
+struct binary_op
+{
+   int precedence; //0 if not a binary op at all
+   bool right; //Associates to the right: a ^ b ^ c is a ^ (b ^ c)
+};
+
+struct binary_op_table
+{
+   binary_op ops[n_token_kinds];
+};
+
+constexpr binary_op_table build_binary_op_table()
+{
+   binary_op_table table = {{}};
+
+   table.ops[(size_t) token_kind::OP_EQ] = {4, false};
+   table.ops[(size_t) token_kind::OP_NE] = {4, false};
+   table.ops[(size_t) token_kind::OP_LT] = {6, false};
+   table.ops[(size_t) token_kind::OP_GT] = {6, false};
+   table.ops[(size_t) token_kind::OP_LE] = {6, false};
+   table.ops[(size_t) token_kind::OP_GE] = {6, false};
+   table.ops[(size_t) token_kind::OP_ADD] = {8, false};
+   table.ops[(size_t) token_kind::OP_SUB] = {8, false};
+   table.ops[(size_t) token_kind::OP_MUL] = {10, false};
+   table.ops[(size_t) token_kind::OP_DIV] = {10, false};
+   table.ops[(size_t) token_kind::OP_MOD] = {10, false};
+   table.ops[(size_t) token_kind::OP_ROOT] = {12, true};
+   table.ops[(size_t) token_kind::OP_EXP] = {13, true};
+
+   return table;
+}
+
+//Indexed by token_kind
+constexpr binary_op_table binary_ops = build_binary_op_table();
 
 class ParseInfo
 /*
   Helpers for Expressions.
   TODO Move these to Expression:: ?
+
+  There's one of these per Parser, made with it and passed by
+  reference all through parsing and generation, so anything worth
+  working out once (like llvm::Types) can be kept here.
 */
 {
 private:
-   //This is somewhat redundant with the token_kind::OP_*s...
-   static const std::map<token_kind, int> precedences;
-
    //TODO refigure this structure somehow
    llvm::LLVMContext& context;
-   
+
+   Interner& names;
+
+   ParseArena& arena; //Where the tree being parsed lives
+
+   //llvm::Types of primitives, by token_kind and by symbol; nullptr
+   //for anything that isn't one (yet)
+   std::array<llvm::Type*, n_token_kinds> kindTypes;
+   std::vector<llvm::Type*> types;
+
 public:
 
    //(This is because of 'context', above; it's bad
-   ParseInfo(ParseBuild& build);
+   ParseInfo(ParseBuild& build, Interner& nms, ParseArena& ar);
+
+   ParseInfo(const ParseInfo&) = delete;
+   ParseInfo& operator= (const ParseInfo&) = delete;
+
+   Interner& GetNames() const;
+   ParseArena& GetArena() const;
 
    bool get_literal_int(const std::string& str, int& result);
-   //TODO: get_literal_float, get_literal_string (not sure how latter works)
+   bool get_literal_float(const std::string& str, float& result);
+   //TODO: get_literal_string (not sure how it works)
    int get_binary_precedence(const token& tok) const;
-   bool is_valid_func_name(const std::string& str) const;
-   bool is_valid_type_name(const std::string& str) const;
+   int get_binary_precedence(token_kind kind) const;
+   const binary_op& get_binary_op(token_kind kind) const;
+   bool is_valid_func_name(llvm::StringRef str) const;
+   bool is_valid_type_name(llvm::StringRef str) const;
    //TODO this one is badly named; includes NAME tokens that could be types
    bool is_type_token(const token& tok) const;
    bool is_literal(const token_kind& tok) const;
    bool is_rhs_end(const token_kind& tok) const;
 
    //Messy helpers. TODO just bundle stuff with tokens instead?
-   llvm::Type* GetType(const std::string str);
-   llvm::Type* GetType(const token_kind tok);
-   size_t GetTypeSize(const std::string& str) const;
+   llvm::Type* GetType(symbol typ) const;
+   llvm::Type* GetType(const token_kind tok) const;
+   size_t GetTypeSize(symbol typ) const;
 };
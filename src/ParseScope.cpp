@@ -1,23 +1,80 @@
 #include "ParseScope.hpp"
 
-map<string, llvm::AllocaInst*>&
-ParseScope::push_scope()
+ParseScope::ParseScope()
+   : table (64, slot {empty, nothing})
+   , used (0)
 {
-   names.emplace_back();
+}
+
+ParseScope::slot&
+ParseScope::find_slot(symbol nm)
+{
+   //Symbols are dense, so a multiplicative hash spreads them fine
+   size_t mask = table.size() - 1;
+   size_t i = (nm * 0x9e3779b1u) & mask;
+
+   while ((table[i].name != nm) && (table[i].name != empty))
+      i = (i + 1) & mask;
 
-   return names.back();
+   return table[i];
+}
+
+void
+ParseScope::grow()
+{
+   vector<slot> old (table.size() * 2, slot {empty, nothing});
+
+   old.swap(table);
+
+   for (const slot& s : old)
+   {
+      if (s.name != empty)
+	 find_slot(s.name) = s;
+   }
+}
+
+void
+ParseScope::push_scope()
+{
+   levels.push_back(bindings.size());
 }
 
 void
 ParseScope::pop_scope()
 {
-   names.pop_back();
+   //Unbind everything bound since the level was pushed, innermost
+   //first, so that whatever each one shadowed is uncovered
+   uint32_t start = levels.back();
+
+   levels.pop_back();
+
+   while (bindings.size() > start)
+   {
+      const binding& bnd = bindings.back();
+
+      find_slot(bnd.name).innermost = bnd.shadowed;
+
+      bindings.pop_back();
+   }
 }
 
 void
-ParseScope::push_to_scope(const string& name, llvm::AllocaInst* var)
+ParseScope::push_to_scope(symbol name, llvm::AllocaInst* var)
 {
-   names.back()[name] = var;
+   if ((used + 1) * 2 > table.size())
+      grow();
+
+   slot& s = find_slot(name);
+
+   if (s.name == empty)
+   {
+      s.name = name;
+      ++used;
+   }
+
+   bindings.push_back(binding {var, name, s.innermost});
+
+   s.innermost = bindings.size() - 1;
 }
 
 //pop_from_scope if there's some kind of delete operation? But then
@@ -26,18 +83,16 @@ ParseScope::push_to_scope(const string& name, llvm::AllocaInst* var)
 //deleted ones? It might not need be a stack.
 
 llvm::AllocaInst*
-ParseScope::is_in_scope(const string& nm)
+ParseScope::is_in_scope(symbol nm)
 {
-   //Proceed from nearest scope out
-   for (int i = names.size() - 1; i > -1; --i)
-   {
-      if (names[i].count(nm))
-      {
-	 return names[i].at(nm); //because at() can be const
-      }
-   }
-      
-   return nullptr;
+   //Only ever the innermost binding; no need to go out through the
+   //levels
+   uint32_t innermost = find_slot(nm).innermost;
+
+   if (innermost == nothing)
+      return nullptr;
+
+   return bindings[innermost].var;
 
    /*
      TODO: what about overloading? i.e., the scope is wider than
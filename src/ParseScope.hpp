@@ -1,9 +1,11 @@
 #pragma once
 
+#include "lexer.hpp"
+
 #include "llvm/IR/Instructions.h"
 
-#include <string>
-#include <map>
+#include <cstdint>
+#include <vector>
 
 using namespace std;
 
@@ -14,24 +16,59 @@ class ParseScope
   Generation is never going to 'go back' to scopes that have 
   collapsed, so scope really can be a stack, with previously 
   higher level sections of the stack being discarded.
+
+  Rather than a map per level, it's one open-addressing table from
+  symbol to that name's innermost binding. Each binding points back
+  to the one it shadows, and bindings are kept in the order they were
+  made, so popping a level just unwinds the bindings made since it
+  was pushed. Looking up a name costs the same however deep it is.
 */
 {
 private:
-   //Stack of names in scope
-   //(can't be std::stack because is_in_scope accesses all indices)
-   vector<map<string, llvm::AllocaInst*>> names;
+   static const uint32_t nothing = ~(uint32_t) 0;
+
+   //Interner::none; never the name of a variable, so marks an empty
+   //slot
+   static const symbol empty = 0;
+
+   struct binding
+   {
+      llvm::AllocaInst* var;
+      symbol name;
+      uint32_t shadowed; //Binding of the same name further out
+   };
+
+   struct slot
+   {
+      symbol name;
+      uint32_t innermost; //Index into bindings, or nothing
+   };
+
+   //Size a power of 2, at most half full. A name keeps its slot once
+   //it has one, bound or not.
+   vector<slot> table;
+   size_t used;
+
+   //Every binding in scope, innermost last; and where in it each
+   //level of scope starts
+   vector<binding> bindings;
+   vector<uint32_t> levels;
    //TODO: will probably need another for refs
    //TODO: Might need another, for variables that have been
    //implicitly deleted. Needn't be a stack...?
 
+   slot& find_slot(symbol nm);
+   void grow();
+
 public:
+   ParseScope();
 
    //Push/pop an entire level of scope
-   map<string, llvm::AllocaInst*>& push_scope();
+   void push_scope();
    void pop_scope();
    //Push a name to the current top level scope
-   void push_to_scope(const string& name, llvm::AllocaInst* var);
+   void push_to_scope(symbol name, llvm::AllocaInst* var);
    //No need for pop_from_scope
 
-   llvm::AllocaInst* is_in_scope(const string& nm);
+   llvm::AllocaInst* is_in_scope(symbol nm);
 };
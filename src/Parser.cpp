@@ -1,6 +1,7 @@
 #include "Parser.hpp"
 
 #include "log.hpp"
+#include "LazyJIT.hpp"
 
 //for top-level parsing
 #include "exprs/subexprs/FunctionExpression.hpp"
@@ -8,66 +9,228 @@
 //for llvm::errs() - hopefully temporary
 #include "llvm/Support/raw_ostream.h"
 
+#include <atomic>
+#include <thread>
+
 using namespace std;
 
 token_stream::token_stream()
-   : pos (0)
-   , cur (token(token_kind::INVALID))
+   : lex (nullptr)
+   , toks (nullptr)
+   , next (0)
+   , last (0)
+   , ring {token(token_kind::INVALID), token(token_kind::END)}
+   , head (0)
+{
+}
+
+token_stream::token_stream(lexer& lx)
+   : lex (&lx)
+   , toks (nullptr)
+   , next (0)
+   , last (0)
+   , ring {pull(), pull()}
+   , head (0)
+{
+}
+
+token_stream::token_stream(const token_string& nStr)
+   : lex (nullptr)
+   , toks (&nStr)
+   , next (0)
+   , last (nStr.size())
+   , ring {pull(), pull()}
+   , head (0)
 {
 }
 
-token_stream::token_stream(token_string nStr)
-   : str (nStr)
-   , pos (0)
-   , cur (str.size() ? str[0] : token(token_kind::END))
+token_stream::token_stream(const token_string& nStr, size_t first, size_t lst)
+   : lex (nullptr)
+   , toks (&nStr)
+   , next (first)
+   , last (lst)
+   , ring {pull(), pull()}
+   , head (0)
 {
 }
 
+token
+token_stream::pull()
+{
+   if (lex)
+      return lex->next_token();
+
+   if (toks && (next < last))
+      return (*toks)[next++];
+
+   else return token(token_kind::END);
+}
+
 const token
 token_stream::get()
 {
-   token tok = token(token_kind::END);
-   
-   if ((pos + 1) < str.size())
-   {
-      ++pos;
+   //The slot of the token being left behind is refilled from the
+   //source, and becomes the furthest lookahead.
+   ring[head] = pull();
 
-      tok = str[pos];
-   }
+   head = (head + 1) & (window - 1);
       
-   return cur = tok;
+   return ring[head];
 }
 
 const token
 token_stream::peek() const
 {
-   if ((pos + 1) < str.size())
-      return str[pos + 1];
-
-   else return token(token_kind::END);
+   return ring[(head + 1) & (window - 1)];
 }
 
 const token
 token_stream::cur_tok() const
 {
-   return cur;
+   return ring[head];
 }
 
 //
 
 Parser::Parser()
+   : info (build, names, arena)
+   , ssa (false)
+   , fastMath (false)
+   , vectorizeWidth (0)
+   , unrollCount (0)
+{
+}
+
+void
+Parser::SetSSA(bool on)
+{
+   ssa = on;
+
+   build.SetSSA(on);
+}
+
+void
+Parser::SetFastMath(bool on)
 {
+   fastMath = on;
+
+   build.SetFastMath(on);
+}
+
+void
+Parser::SetLoopHints(unsigned width, unsigned unroll)
+{
+   vectorizeWidth = width;
+   unrollCount = unroll;
+
+   build.SetLoopHints(width, unroll);
+}
+
+Interner&
+Parser::GetNames()
+{
+   return names;
 }
 
 void
 Parser::printTree()
 {
+   if (!flat.empty())
+   {
+      flat.print(cout, names);
+
+      return;
+   }
+
    for (unsigned int i = 0; i < parsed.size(); ++i)
    {
-      cout << *parsed[i].get();
+      parsed[i]->print(cout, names);
    }
 }
 
+static void
+print_stats(const string& when, const ParseBuild::stats& st)
+{
+   cout << when << ": " <<
+      st.functions << " functions, " <<
+      st.blocks << " blocks, " <<
+      st.instructions << " instructions, " <<
+      st.bitcode << " bytes of bitcode" << endl;
+}
+
+void
+Parser::Fold(bool stats)
+{
+   ParseFold fold(arena);
+
+   for (Expression*& expr : parsed)
+      expr = expr->Fold(fold);
+
+   if (stats)
+   {
+      cout << "Folded: " << fold.NodesBefore() << " nodes before, " <<
+	 fold.NodesAfter() << " after" << endl;
+   }
+}
+
+void
+Parser::PrintStats(const string& when)
+{
+   print_stats(when, build.GetStats());
+}
+
+void
+Parser::Optimise(unsigned level, bool stats)
+{
+   string lvl = " -O" + to_string(level);
+
+   if (stats)
+      print_stats("Before" + lvl, build.GetStats());
+
+   build.Optimise(level);
+
+   if (stats)
+      print_stats("After" + lvl, build.GetStats());
+}
+
+bool
+Parser::SetTarget(const string& cpu, unsigned level)
+{
+   return build.SetTarget(cpu, level);
+}
+
+bool
+Parser::SetJITTarget()
+{
+   return build.SetJITTarget();
+}
+
+bool
+Parser::Emit(const string& path, bool assembly, llvm::ObjectCache* cache)
+{
+   return build.Emit(path, assembly, cache);
+}
+
+bool
+Parser::EmitIR(const string& path, bool bitcode)
+{
+   return build.EmitIR(path, bitcode);
+}
+
+bool
+Parser::Run(const string& entry, llvm::ObjectCache* cache)
+{
+   return build.Run(entry, cout, cache);
+}
+
+bool
+Parser::RunLazy(const string& entry, int level)
+{
+   LazyJIT lazy(names, arena, parsed, level, ssa, fastMath, vectorizeWidth, unrollCount);
+
+   return lazy.Run(entry, cout);
+}
+
 void
 Parser::printIR()
 {
@@ -75,52 +238,190 @@ Parser::printIR()
 }
 
 void
-Parser::Parse(token_string toks)
+Parser::Parse(lexer& lx)
+{
+   str = token_stream(lx);
+
+   ParseFunctions();
+}
+
+void
+Parser::Parse(const token_string& toks)
 {   
-   //TODO Might isolate this
    str = token_stream(toks);
 
-   while (str.cur_tok().GetKind() != token_kind::END)
+   ParseFunctions();
+}
+
+void
+Parser::Parse(const token_string& toks, unsigned jobs)
+{
+   vector<size_t> bounds = split_functions(toks);
+
+   size_t nSpans = bounds.size() - 1;
+
+   if ((jobs < 2) || (nSpans < 2))
    {
-      unique_ptr<Expression> func = FunctionExpression::Parse(str,
-							      ParseInfo(build));
+      Parse(toks);
 
-      if (!func)
+      return;
+   }
+
+   size_t nThreads = std::min<size_t>(jobs, nSpans);
+
+   //Each thread parses into its own arena, through its own ParseInfo.
+   //Both are made here, as making a ParseInfo touches the LLVMContext.
+   vector<unique_ptr<ParseInfo>> infos;
+
+   for (size_t t = 0; t < nThreads; ++t)
+   {
+      arenas.push_back(std::make_unique<ParseArena>());
+      infos.push_back(std::make_unique<ParseInfo>(build, names, *arenas.back()));
+   }
+
+   struct span_result
+   {
+      vector<Expression*> parsed;
+      vector<Error> errors; //Logged by this span, to be logged in order
+      bool failed;
+   };
+
+   vector<span_result> results(nSpans);
+
+   atomic<size_t> nextSpan(0);
+
+   //Sequential parsing stops at the first span that fails, so nothing
+   //after that is needed
+   atomic<size_t> firstFailed(nSpans);
+
+   auto worker = [&] (size_t t)
+   {
+      for (size_t i; (i = nextSpan++) < nSpans;)
+      {
+	 if (i > firstFailed)
+	    break;
+
+	 span_result& res = results[i];
+	 token_stream s(toks, bounds[i], bounds[i + 1]);
+
+	 Log::begin_capture(res.errors);
+
+	 res.failed = !ParseFunctions(s, *infos[t], res.parsed);
+
+	 Log::end_capture();
+
+	 if (res.failed)
+	 {
+	    size_t prev = firstFailed;
+
+	    while ((i < prev) && !firstFailed.compare_exchange_weak(prev, i));
+	 }
+      }
+   };
+
+   vector<thread> threads;
+
+   for (size_t t = 1; t < nThreads; ++t)
+      threads.emplace_back(worker, t);
+
+   worker(0);
+
+   for (thread& t : threads)
+      t.join();
+
+   //Put it all together in source order, as if parsed in one go
+   for (size_t i = 0; i < nSpans; ++i)
+   {
+      span_result& res = results[i];
+
+      parsed.insert(parsed.end(), res.parsed.begin(), res.parsed.end());
+
+      for (const Error& err : res.errors)
+	 Log::log_error(err);
+
+      if (res.failed)
       {
 	 Log::log_error(Error(0, 0, "Failed to parse FunctionExpression."));
-	 
+
 	 break;
       }
+   }
+}
+
+vector<size_t>
+Parser::split_functions(const token_string& toks)
+{
+   vector<size_t> bounds(1, 0);
+
+   int depth = 0;
+
+   for (size_t i = 0; i < toks.size(); ++i)
+   {
+      token_kind knd = toks[i].GetKind();
+
+      if (knd == token_kind::BRACE_OPEN)
+	 ++depth;
 
-      else parsed.push_back(move(func));
+      //A stray '}' ends a span too; whichever function it's in will
+      //fail on it either way
+      else if ((knd == token_kind::BRACE_CLOSE) && (--depth <= 0))
+      {
+	 depth = 0;
+
+	 bounds.push_back(i + 1);
+      }
    }
+
+   //Anything after the last function (if only END) is a span of its
+   //own
+   if (bounds.back() != toks.size())
+      bounds.push_back(toks.size());
+
+   return bounds;
 }
 
-//TODO remove
-int main(int argc, char** argv)
+bool
+Parser::Flatten()
 {
-   lexer lexer;
+   flat.clear();
 
-   if (argc <= 1)
+   for (Expression* expr : parsed)
    {
-      return 1;
+      flat_id id = expr->Flatten(flat);
+
+      if (id == FlatTree::none)
+      {
+	 //Fall back on the Expression tree
+	 flat.clear();
+
+	 return false;
+      }
+
+      flat.add_root(id);
    }
-   
-   token_string toks = lexer.lex(argv[1]);
-   
-   //cout << toks;
-   
-   Parser prs;
 
-   prs.Parse(toks);
+   return true;
+}
 
-   //prs.printTree();
+void
+Parser::ParseFunctions()
+{
+   if (!ParseFunctions(str, info, parsed))
+      Log::log_error(Error(0, 0, "Failed to parse FunctionExpression."));
+}
 
-   prs.Generate();
+bool
+Parser::ParseFunctions(token_stream& s, ParseInfo& inf, vector<Expression*>& out)
+{
+   while (s.cur_tok().GetKind() != token_kind::END)
+   {
+      Expression* func = FunctionExpression::Parse(s, inf);
 
-   prs.printIR();
+      if (!func)
+	 return false;
 
-   Log::print();
+      out.push_back(func);
+   }
 
-   return 0;
+   return true;
 }
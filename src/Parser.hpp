@@ -5,6 +5,10 @@
 #include "ParseBuild.hpp"
 #include "ParseScope.hpp"
 #include "ParseInfo.hpp"
+#include "Interner.hpp"
+#include "ParseArena.hpp"
+#include "FlatTree.hpp"
+#include "ParseFold.hpp"
 
 class token_stream;
 
@@ -20,18 +24,37 @@ using namespace std;
 
 class Expression;
 
-//Temporary, until lexer streams tokens...?
 class token_stream
+/*
+  The parser's view of the tokens. Either pulls them from a lexer on
+  demand, so only the lookahead is ever held, or walks a token_string
+  that was lexed up front. Either way the current token and the
+  lookahead sit in a small ring buffer.
+*/
 {
 private:
-   token_string str;
-   size_t pos;
+   //Current token plus peek(); must be a power of 2
+   static const size_t window = 2;
+
+   //Source: a lexer if streaming, otherwise a token_string (owned by
+   //the caller), the index of the next token to take from it and the
+   //index to stop at
+   lexer* lex;
+   const token_string* toks;
+   size_t next;
+   size_t last;
 
-   token cur; //Current token
+   token ring[window];
+   size_t head; //Index of current token in ring
+
+   token pull(); //Next token from the source
 
 public:
    token_stream();
-   token_stream(token_string nStr);
+   token_stream(lexer& lx);
+   token_stream(const token_string& nStr);
+   //Just tokens [first, last) of nStr, then END
+   token_stream(const token_string& nStr, size_t first, size_t last);
    
    const token get(); //Get and advance stream
    const token peek() const; //Get but don't advance stream
@@ -45,7 +68,17 @@ class Parser
 */
 {
 private:
-   vector<unique_ptr<Expression>> parsed;
+   Interner names; //Every name lexed, parsed or generated
+
+   //Every Expression parsed lives here, and goes in one go with the
+   //Parser
+   ParseArena arena;
+   //And those parsed by other threads (see Parse(toks, jobs)) in
+   //theirs
+   vector<unique_ptr<ParseArena>> arenas;
+
+   vector<Expression*> parsed;
+   FlatTree flat; //parsed again, if Flatten()ed
    vector<llvm::Value*> generated;
 
    token_stream str;
@@ -53,11 +86,77 @@ private:
    ParseScope scope; //Scope, for generation
    ParseBuild build; //LLVM stuff
 
+   ParseInfo info; //For the whole of parsing and generation
+
+   bool ssa; //See SetSSA()
+   bool fastMath; //See SetFastMath()
+   unsigned vectorizeWidth; //See SetLoopHints()
+   unsigned unrollCount;
+
+   void ParseFunctions(); //Parse all of str
+
+   //Parse functions from s into out until END; false if one fails
+   static bool ParseFunctions(token_stream& s, ParseInfo& inf,
+			      vector<Expression*>& out);
+
+   //Where each top-level function in toks starts, plus toks.size().
+   //Each ends with the '}' that brings the braces back to level
+   static vector<size_t> split_functions(const token_string& toks);
+
 public:
    Parser();
+
+   //For the lexer to intern names into
+   Interner& GetNames();
    
-   void Parse(token_string toks);
+   void Parse(lexer& lx); //Parse while lexing
+   void Parse(const token_string& toks);
+   //Parse the top-level functions of toks over 'jobs' threads. Comes
+   //out just as Parse(toks) would, errors included
+   void Parse(const token_string& toks, unsigned jobs);
+
+   //Generate locals as SSA values; see ParseBuild::SetSSA()
+   void SetSSA(bool on);
+   //Do float math fast, not exactly; see ParseBuild::SetFastMath()
+   void SetFastMath(bool on);
+   //Metadata for every loop; see ParseBuild::SetLoopHints()
+   void SetLoopHints(unsigned width, unsigned unroll);
+
+   //Fold constants in the parsed tree (see ParseFold), before it's
+   //generated. If 'stats', print how many nodes it had before and after
+   void Fold(bool stats);
+   //Print the size of what's been generated, as of 'when'
+   void PrintStats(const string& when);
+
+   //Lay the parsed tree out flat, to generate from that instead; false
+   //(and nothing changes) if some of it can't be
+   bool Flatten();
    void Generate();
+   /*
+     Generate over 'jobs' threads, each into a module of its own, and
+     run LLVM's passes for -O<level> (unless it's -1) over each there
+     too, then link those into the one module. So do SetTarget() first,
+     and not Optimise() after. Nothing's inlined between modules.
+     Below -O1 it's just Generate(), as there'd be nothing to gain.
+   */
+   void Generate(unsigned jobs, int level);
+
+   //Run LLVM's passes for -O<level> over what's been generated. If
+   //'stats', print the size of the module before and after
+   void Optimise(unsigned level, bool stats);
+
+   //Generate machine code for this machine; see ParseBuild::SetTarget()
+   bool SetTarget(const string& cpu, unsigned level);
+   //Or for Run()'s JIT; see ParseBuild::SetJITTarget()
+   bool SetJITTarget();
+   bool Emit(const string& path, bool assembly, llvm::ObjectCache* cache);
+   bool EmitIR(const string& path, bool bitcode);
+   //JIT and call 'entry'; see ParseBuild::Run(). Last thing to do
+   bool Run(const string& entry, llvm::ObjectCache* cache);
+   //The same, but straight after parsing, generating each function
+   //only when it's first called (see LazyJIT), at -O<level> if
+   //level isn't -1
+   bool RunLazy(const string& entry, int level);
 
    void printTree(); //Print a representation of the tree. Very rough
    void printIR(); //Dump LLVM IR generated
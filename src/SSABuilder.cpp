@@ -0,0 +1,183 @@
+#include "SSABuilder.hpp"
+
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Constants.h"
+
+SSABuilder::SSABuilder()
+{
+}
+
+SSABuilder::~SSABuilder()
+{
+   Finish();
+}
+
+llvm::AllocaInst*
+SSABuilder::Declare(llvm::Type* typ, llvm::StringRef name)
+{
+   //(Alignment given, as otherwise it's looked up through where it's
+   //inserted)
+   llvm::AllocaInst* var = new llvm::AllocaInst(typ, 0, nullptr, llvm::Align(1), name);
+
+   vars.push_back(var);
+
+   return var;
+}
+
+void
+SSABuilder::Write(llvm::AllocaInst* var, llvm::BasicBlock* block, llvm::Value* val)
+{
+   defs[def_key(block, var)] = val;
+}
+
+llvm::Value*
+SSABuilder::Read(llvm::AllocaInst* var, llvm::BasicBlock* block)
+{
+   auto found = defs.find(def_key(block, var));
+
+   if ((found != defs.end()) && found->second)
+      return found->second;
+
+   return ReadRecursive(var, block);
+}
+
+llvm::Value*
+SSABuilder::ReadRecursive(llvm::AllocaInst* var, llvm::BasicBlock* block)
+{
+   llvm::Value* val;
+
+   if (!sealed.count(block))
+   {
+      //Not all predecessors known yet: an operandless phi, filled in
+      //by Seal()
+      llvm::PHINode* phi = NewPhi(var, block);
+
+      incomplete[block].push_back({var, phi});
+
+      val = phi;
+   }
+
+   else if (llvm::BasicBlock* pred = block->getSinglePredecessor())
+   {
+      //No phi needed
+      val = Read(var, pred);
+   }
+
+   else if (llvm::pred_empty(block))
+   {
+      //The entry block, and it was never written
+      val = llvm::UndefValue::get(var->getAllocatedType());
+   }
+
+   else
+   {
+      //Written first, so that a loop back to here finds the phi rather
+      //than going round forever
+      llvm::PHINode* phi = NewPhi(var, block);
+
+      Write(var, block, phi);
+
+      val = AddPhiOperands(var, phi);
+   }
+
+   Write(var, block, val);
+
+   return val;
+}
+
+llvm::PHINode*
+SSABuilder::NewPhi(llvm::AllocaInst* var, llvm::BasicBlock* block)
+{
+   if (block->empty())
+      return llvm::PHINode::Create(var->getAllocatedType(), 0, var->getName(), block);
+
+   return llvm::PHINode::Create(var->getAllocatedType(), 0, var->getName(), &block->front());
+}
+
+llvm::Value*
+SSABuilder::AddPhiOperands(llvm::AllocaInst* var, llvm::PHINode* phi)
+{
+   for (llvm::BasicBlock* pred : llvm::predecessors(phi->getParent()))
+      phi->addIncoming(Read(var, pred), pred);
+
+   return TryRemoveTrivialPhi(phi);
+}
+
+llvm::Value*
+SSABuilder::TryRemoveTrivialPhi(llvm::PHINode* phi)
+{
+   llvm::Value* same = nullptr;
+
+   for (llvm::Value* op : phi->incoming_values())
+   {
+      //Unique value, or a reference to itself
+      if ((op == same) || (op == phi))
+	 continue;
+
+      //Merges at least two values: not trivial
+      if (same)
+	 return phi;
+
+      same = op;
+   }
+
+   //Unreachable, or in the entry block
+   if (!same)
+      same = llvm::UndefValue::get(phi->getType());
+
+   //Other phis using this one might become trivial in turn. (Held by
+   //handles that go null if one's removed before its turn)
+   std::vector<llvm::WeakVH> users;
+
+   for (llvm::User* user : phi->users())
+   {
+      llvm::PHINode* other = llvm::dyn_cast<llvm::PHINode>(user);
+
+      if (other && (other != phi))
+	 users.push_back(other);
+   }
+
+   phi->replaceAllUsesWith(same);
+   phi->eraseFromParent();
+
+   for (llvm::WeakVH& user : users)
+   {
+      if (llvm::PHINode* other = llvm::dyn_cast_or_null<llvm::PHINode>((llvm::Value*) user))
+	 TryRemoveTrivialPhi(other);
+   }
+
+   return same;
+}
+
+void
+SSABuilder::Seal(llvm::BasicBlock* block)
+{
+   auto found = incomplete.find(block);
+
+   sealed.insert(block);
+
+   if (found == incomplete.end())
+      return;
+
+   //Taken out first; filling these in can add to incomplete
+   std::vector<std::pair<llvm::AllocaInst*, llvm::PHINode*>> phis = std::move(found->second);
+
+   incomplete.erase(found);
+
+   for (auto& var_phi : phis)
+      AddPhiOperands(var_phi.first, var_phi.second);
+}
+
+void
+SSABuilder::Finish()
+{
+   defs.clear();
+   sealed.clear();
+   incomplete.clear();
+
+   //They were never used as operands, only as keys
+   for (llvm::AllocaInst* var : vars)
+      var->deleteValue();
+
+   vars.clear();
+}
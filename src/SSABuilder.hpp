@@ -0,0 +1,69 @@
+#pragma once
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/ValueHandle.h"
+
+#include <utility>
+#include <vector>
+
+class SSABuilder
+/*
+  Local variables as SSA values, built as generation goes (Braun et
+  al., "Simple and Efficient Construction of Static Single Assignment
+  Form"), rather than as allocas for passes to clean up afterwards.
+
+  A variable is still an AllocaInst, so that ParseScope and
+  GenerateLHS() don't need to know the difference, but one that's
+  never put in a function: it's just the variable's type and name.
+  What it holds in each block is the last value written to it there;
+  reading it where nothing was written looks back through the block's
+  predecessors, putting phis where they meet. A block must be sealed
+  once all of its predecessors are known, and phis put in it before
+  then are finished off at that point. Phis that turn out to pick the
+  same value every way are removed.
+
+  Nothing can take a variable's address yet (refs aren't generated),
+  so every local and param can live in registers.
+*/
+{
+private:
+   typedef std::pair<llvm::BasicBlock*, llvm::AllocaInst*> def_key;
+
+   //Value of each variable at the end of each block so far. Handles
+   //follow replaceAllUsesWith(), so a trivial phi replaced by its
+   //value is replaced here too
+   llvm::DenseMap<def_key, llvm::WeakTrackingVH> defs;
+
+   llvm::SmallPtrSet<llvm::BasicBlock*, 8> sealed;
+   //Phis put in blocks not yet sealed, to be given operands when they
+   //are
+   llvm::DenseMap<llvm::BasicBlock*, std::vector<std::pair<llvm::AllocaInst*, llvm::PHINode*>>> incomplete;
+
+   //Every variable declared, to be deleted by Finish()
+   std::vector<llvm::AllocaInst*> vars;
+
+   llvm::Value* ReadRecursive(llvm::AllocaInst* var, llvm::BasicBlock* block);
+   llvm::PHINode* NewPhi(llvm::AllocaInst* var, llvm::BasicBlock* block);
+   llvm::Value* AddPhiOperands(llvm::AllocaInst* var, llvm::PHINode* phi);
+   llvm::Value* TryRemoveTrivialPhi(llvm::PHINode* phi);
+
+public:
+   SSABuilder();
+   ~SSABuilder();
+
+   //A new variable of that type; never inserted anywhere
+   llvm::AllocaInst* Declare(llvm::Type* typ, llvm::StringRef name);
+
+   void Write(llvm::AllocaInst* var, llvm::BasicBlock* block, llvm::Value* val);
+   //Its value in block; undef if it was never written
+   llvm::Value* Read(llvm::AllocaInst* var, llvm::BasicBlock* block);
+
+   //No more predecessors will be added to block
+   void Seal(llvm::BasicBlock* block);
+
+   //Done with the function; forget its variables
+   void Finish();
+};
@@ -1,42 +1,69 @@
 #include "Expression.hpp"
 
-ostream&
-operator<< (ostream& stream, Expression& expr)
-{
-   return expr.print(stream);
-}
-
 token
 Expression::GetType()
 {
    //This is the default, overrided by expressions for which it makes sense
-   return token(token_kind::INVALID, string());
+   return token(token_kind::INVALID);
 }
 
-string
+symbol
 Expression::GetSubject()
 {
-   return string();
+   return Interner::none;
 }
 
-string
+symbol
 Expression::GetFuncName() const
 {
-   return string();
+   return Interner::none;
 }
 
-string
+symbol
 Expression::GetParamName(size_t index)
 {
-   return string();
+   return Interner::none;
+}
+
+flat_id
+Expression::Flatten(FlatTree& flat)
+{
+   return FlatTree::none;
+}
+
+Expression*
+Expression::Fold(ParseFold& fold)
+{
+   //Nothing in it to fold
+   fold.Count();
+
+   return this;
+}
+
+Expression*
+Expression::FoldLHS(ParseFold& fold)
+{
+   return Fold(fold);
+}
+
+bool
+Expression::GetLitInt(int& value) const
+{
+   return false;
+}
+
+bool
+Expression::IsInt(const ParseFold& fold) const
+{
+   return false;
 }
 
 llvm::Value*
-Expression::GenerateLHS(ParseScope& scope, ParseBuild& build, ParseInfo info)
+Expression::GenerateLHS(ParseScope& scope, ParseBuild& build, ParseInfo& info)
 { return nullptr; }
    
 llvm::Value*
-Expression::GenerateRHS(ParseScope& scope, ParseBuild& build, ParseInfo info)
+Expression::GenerateRHS(ParseScope& scope, ParseBuild& build, ParseInfo& info)
 { return nullptr; }
 
 token_kind
@@ -46,7 +73,7 @@ Expression::GetParamType(size_t index) const
 }
 
 bool
-Expression::IsParam(string paramName) const
+Expression::IsParam(symbol paramName) const
 {
    return false;
 }
@@ -3,7 +3,10 @@
 #include "../Parser.hpp"
 #include "../log.hpp"
 
-#include "../../llvm/IR/Value.h"
+#include "llvm/IR/Value.h"
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
 
 #include <iostream>
 #include <string>
@@ -29,29 +32,42 @@ public:
      virtual/override.
    */
 
-   friend ostream& operator<< (ostream& stream, Expression& expr);
+   //Names are symbols; printing needs the Interner to spell them
+   virtual ostream& print(ostream& stream, const Interner& names) = 0;
+   virtual llvm::Value* Generate(ParseScope& scope, ParseBuild& build, ParseInfo& info) = 0;
+
+   //Add this (and its children) to a FlatTree; FlatTree::none if it
+   //has no flat form
+   virtual flat_id Flatten(FlatTree& flat);
 
-   virtual ostream& print(ostream& stream) = 0;
-   virtual llvm::Value* Generate(ParseScope& scope, ParseBuild& build, ParseInfo info) = 0;
+   //Fold constants and simplify (see ParseFold); what should replace
+   //this in the tree, which may be this. FoldLHS() as GenerateLHS()
+   virtual Expression* Fold(ParseFold& fold);
+   virtual Expression* FoldLHS(ParseFold& fold);
+   //If this is an int literal, its value
+   virtual bool GetLitInt(int& value) const;
+   //If this is known (to fold) to be an int, rather than a float or
+   //not known
+   virtual bool IsInt(const ParseFold& fold) const;
 
    //These two are for VarExpressions, which need to call different
    //Generate()s depending on l- or r-value.
-   virtual llvm::Value* GenerateLHS(ParseScope& scope, ParseBuild& build, ParseInfo info);
-   virtual llvm::Value* GenerateRHS(ParseScope& scope, ParseBuild& build, ParseInfo info);
+   virtual llvm::Value* GenerateLHS(ParseScope& scope, ParseBuild& build, ParseInfo& info);
+   virtual llvm::Value* GenerateRHS(ParseScope& scope, ParseBuild& build, ParseInfo& info);
 
-   static unique_ptr<Expression> Parse(token_stream& str,
-				       ParseInfo info);
+   static Expression* Parse(token_stream& str,
+			    ParseInfo& info);
 
    //Kind of messy: these are just for expressions where
    //'subject' etc are meaningful concepts, but where you don't know
    //whether an exception is -that kind- of exception.
    //TODO would at least be better if the default threw. That way you
    //could only get something you were expecting.
-   virtual string GetSubject();
-   virtual string GetFuncName() const;
-   virtual string GetParamName(size_t index);
+   virtual symbol GetSubject();
+   virtual symbol GetFuncName() const;
+   virtual symbol GetParamName(size_t index);
    virtual token_kind GetParamType(size_t index) const;
-   virtual bool IsParam(string paramName) const;
+   virtual bool IsParam(symbol paramName) const;
    virtual bool IsVoid() const;
    //Temporarily a token. Might ditch altogether, dependent on
    //TypeExpression etc.
@@ -2,38 +2,40 @@
 
 #include "RHSExpression.hpp"
 
-AssignExpression::AssignExpression(unique_ptr<Expression> left,
-				   unique_ptr<Expression> right)
-   : lhs (move(left))
-   , rhs (move(right))
+AssignExpression::AssignExpression(Expression* left,
+				   Expression* right)
+   : lhs (left)
+   , rhs (right)
 {
 }
 
 ostream&
-AssignExpression::print (ostream& stream)
+AssignExpression::print (ostream& stream, const Interner& names)
 {
    stream << "AssignExpression: " <<  endl;
 
-   stream << "[Assign left hand side:]" << endl << *lhs;
-   stream << "[Assign right hand side:]" << endl << *rhs;
+   stream << "[Assign left hand side:]" << endl;
+   lhs->print(stream, names);
+   stream << "[Assign right hand side:]" << endl;
+   rhs->print(stream, names);
 
    return stream << "AssignExpression end" << endl;
 }
 
-string
+symbol
 AssignExpression::GetSubject()
 {
    if (!lhs)
-      return string();
+      return Interner::none;
 
    else
       return lhs->GetSubject();
 }
 
-unique_ptr<Expression>
+Expression*
 AssignExpression::Parse(token_stream& str,
-			ParseInfo info,
-			unique_ptr<Expression> left)
+			ParseInfo& info,
+			Expression* left)
 {
    //Eat =
    str.get();
@@ -50,7 +52,7 @@ AssignExpression::Parse(token_stream& str,
       return nullptr;
    }
    
-   unique_ptr<Expression> right = RHSExpression::Parse(str, info);
+   Expression* right = RHSExpression::Parse(str, info);
 
    if (right == nullptr)
    {
@@ -64,5 +66,5 @@ AssignExpression::Parse(token_stream& str,
    //Don't check for SEMICOLON here; do it in StatementExpression,
    //which is what calls this.
    
-   return make_unique<AssignExpression>(move(left), move(right));
+   return info.GetArena().make<AssignExpression>(left, right);
 }
@@ -11,20 +11,22 @@
 class AssignExpression : public Expression
 {
 private:
-   unique_ptr<Expression> lhs;
-   unique_ptr<Expression> rhs;
+   Expression* lhs;
+   Expression* rhs;
    
 public:
-   AssignExpression(unique_ptr<Expression> left,
-		    unique_ptr<Expression> right);
+   AssignExpression(Expression* left,
+		    Expression* right);
 
-   ostream& print (ostream& stream) override;
+   ostream& print (ostream& stream, const Interner& names) override;
 
-   static unique_ptr<Expression> Parse(token_stream& str,
-				       ParseInfo info,
-				       unique_ptr<Expression> left);
+   static Expression* Parse(token_stream& str,
+			    ParseInfo& info,
+			    Expression* left);
    
-   llvm::Value* Generate(ParseScope& scope, ParseBuild& build, ParseInfo info) override;
+   llvm::Value* Generate(ParseScope& scope, ParseBuild& build, ParseInfo& info) override;
+   flat_id Flatten(FlatTree& flat) override;
+   Expression* Fold(ParseFold& fold) override;
 
-   string GetSubject() override;
+   symbol GetSubject() override;
 };
@@ -4,99 +4,102 @@
 
 
 BinaryExpression::BinaryExpression(token_kind opKind,
-				   unique_ptr<Expression> left,
-				   unique_ptr<Expression> right)
+				   Expression* left,
+				   Expression* right)
    : op (opKind)
-   , lhs (move(left))
-   , rhs (move(right))
+   , lhs (left)
+   , rhs (right)
 {
 }
 
 ostream&
-BinaryExpression::print (ostream& stream)
+BinaryExpression::print (ostream& stream, const Interner& names)
 {
    token tok = token(op);
 
    stream << "BinaryExpression: " << tok << endl;
 
-   stream << "[Binary left hand side:]" << endl << *lhs;
-   stream << "[Binary right hand side:]" << endl << *rhs;
+   stream << "[Binary left hand side:]" << endl;
+   lhs->print(stream, names);
+   stream << "[Binary right hand side:]" << endl;
+   rhs->print(stream, names);
 
    return stream << "BinaryExpression end" << endl;
 }
 
-unique_ptr<Expression>
+Expression*
 BinaryExpression::Parse(token_stream& str,
-			ParseInfo info,
-			unique_ptr<Expression> left)
+			ParseInfo& info,
+			Expression* left)
 {
    /*
      For clarity: this function starts with the lhs already parsed
-     (left), with cur_tok on a binary expression. get() gets the rhs
-     of the original binary expression (right). After that, we check
-     for -another- binary expression occurring without parentheses;
-     that's a situation which needs disambiguating.
+     (left), with cur_tok on a binary op. It takes every op and
+     operand after that, up to the end of the RHS.
+
+     Precedence climbing, done with explicit stacks rather than by
+     recursing per op, so a long chain of ops costs no stack. Operands
+     and ops are pushed as they come; before pushing an op, any ops
+     already stacked that bind at least as tightly (more tightly, if
+     it's right-associative) are folded into BinaryExpressions, since
+     they have to be evaluated first. Whatever is left is folded at
+     the end.
    */
 
-   token_kind kind = str.cur_tok().GetKind();
-   int precedence = info.get_binary_precedence(kind);
+   llvm::SmallVector<Expression*, 16> operands = {left};
+   llvm::SmallVector<token_kind, 16> ops;
 
-   //Eat binary op
-   str.get();
-   
-   unique_ptr<Expression> right = RHSExpression::Parse(str,
-						       info);
-
-   if (!right)
+   //Fold the top op and its two operands into one operand
+   auto reduce = [&]()
    {
-      Log::log_error(Error(0, 0,
-			   string("Failure parsing right-hand side of a binary operation.")));
-      
-      return nullptr;
-   }
-   
-   //Parse should eat the last relevant token; no get().
+      Expression* right = operands.pop_back_val();
 
-   token_kind furtherKind = str.cur_tok().GetKind();
-   int furtherPrecedence = info.get_binary_precedence(furtherKind);
+      operands.back() = info.GetArena().make<BinaryExpression>(ops.pop_back_val(),
+							       operands.back(),
+							       right);
+   };
 
-   //Don't get() here either; it's to be parsed by another call
-   //whether or not it's another binary op.
-
-   //ie if it's a binary op
-   if (furtherPrecedence)
+   while (true)
    {
-      if (precedence >= furtherPrecedence)
+      token_kind kind = str.cur_tok().GetKind();
+      const binary_op& op = info.get_binary_op(kind);
+
+      //ie if the now current token isn't another binary op
+      if (!op.precedence)
+	 break;
+
+      while (!ops.empty())
       {
-	 //Eat up this binary op and feed into a new BinaryExpression, as
-	 //new left
-	 return BinaryExpression::Parse(str,
-					info,
-					make_unique<BinaryExpression>(kind,
-								      move(left),
-								      move(right)));
-								      
+	 int stacked = info.get_binary_precedence(ops.back());
+
+	 if ((stacked > op.precedence) or
+	     ((stacked == op.precedence) and !op.right))
+	    reduce();
+
+	 else break;
       }
 
-      else
+      ops.push_back(kind);
+
+      //Eat binary op
+      str.get();
+
+      Expression* right = RHSExpression::ParseOperand(str, info);
+
+      if (!right)
       {
-	 /*
-	   Eat up the next one, by making a new parse of it, and feed
-	   it into this one.
-
-	   Whichever 'goes first', ie has the highest precedence, is
-	   not the one that's returned directly, since height in the
-	   tree represents backward-order of operations; the leaves
-	   are evaluated first.
-	  */
-	 return make_unique<BinaryExpression>(furtherKind,
-					      BinaryExpression::Parse(str,
-								      info,
-								      move(right)),
-					      move(left));
+	 Log::log_error(Error(0, 0,
+			      string("Failure parsing right-hand side of a binary operation.")));
+
+	 return nullptr;
       }
+
+      //ParseOperand should eat the last relevant token; no get().
+      operands.push_back(right);
    }
 
-   //i.e., if the now current token isn't another binary op.
-   else return make_unique<BinaryExpression>(kind, move(left), move(right));
+   while (!ops.empty())
+      reduce();
+
+   return operands.back();
 }
@@ -7,19 +7,22 @@ class BinaryExpression : public Expression
 private:
    token_kind op;
       
-   unique_ptr<Expression> lhs;
-   unique_ptr<Expression> rhs;
+   Expression* lhs;
+   Expression* rhs;
 
 public:
    BinaryExpression(token_kind opKind,
-		    unique_ptr<Expression> left,
-		    unique_ptr<Expression> right);
+		    Expression* left,
+		    Expression* right);
 
-   ostream& print (ostream& stream) override;
+   ostream& print (ostream& stream, const Interner& names) override;
    
-   static unique_ptr<Expression> Parse(token_stream& str,
-				       ParseInfo info,
-				       unique_ptr<Expression> left);
+   static Expression* Parse(token_stream& str,
+			    ParseInfo& info,
+			    Expression* left);
    
-   llvm::Value* Generate(ParseScope& scope, ParseBuild& build, ParseInfo info) override;
+   llvm::Value* Generate(ParseScope& scope, ParseBuild& build, ParseInfo& info) override;
+   flat_id Flatten(FlatTree& flat) override;
+   Expression* Fold(ParseFold& fold) override;
+   bool IsInt(const ParseFold& fold) const override;
 };
@@ -1,31 +1,32 @@
 #include "CallExpression.hpp"
 #include "RHSExpression.hpp"
 
-CallExpression::CallExpression(const string& funcName,
-	       vector<unique_ptr<Expression>> argsGiven)
+CallExpression::CallExpression(symbol funcName,
+	       llvm::ArrayRef<Expression*> argsGiven)
    : name (funcName)
-   , args (move(argsGiven))
+   , args (argsGiven)
 {
 }
 
 ostream&
-CallExpression::print (ostream& stream)
+CallExpression::print (ostream& stream, const Interner& names)
 {
-   stream << "CallExpression: " << name << endl;
+   stream << "CallExpression: " << names.name(name).str() << endl;
 
    for (unsigned int i = 0; i < args.size(); ++i)
    {
-      stream << "[Call argument " << i << ":]" << endl << *args[i];
+      stream << "[Call argument " << i << ":]" << endl;
+      args[i]->print(stream, names);
    }
 
    return stream << "CallExpression end" << endl;
 }
 
-unique_ptr<Expression>
+Expression*
 CallExpression::Parse(token_stream& str,
-		      ParseInfo info)
+		      ParseInfo& info)
 {
-   const string curName = str.cur_tok().GetValue();
+   symbol curName = str.cur_tok().GetSymbol();
 
    //This will be called when a NAME is found with a PAREN_OPEN after.
    //So you can immediately eat both.
@@ -35,7 +36,7 @@ CallExpression::Parse(token_stream& str,
    //Eat (
    str.get();
 
-   vector<unique_ptr<Expression>> args;
+   llvm::SmallVector<Expression*, 8> args;
 
    //First time, check close paren.
    if (str.cur_tok().GetKind() == token_kind::PAREN_CLOSE)
@@ -43,15 +44,15 @@ CallExpression::Parse(token_stream& str,
       //Eat )
       str.get();
 
-      return make_unique<CallExpression>(curName,
-					 move(args));
+      return info.GetArena().make<CallExpression>(curName,
+						  llvm::ArrayRef<Expression*>());
    }
 
    //You're effectively expecting at least one parenthesised
    //expression by now.
    while (true)
    {
-      unique_ptr<Expression> arg = RHSExpression::Parse(str, info);
+      Expression* arg = RHSExpression::Parse(str, info);
       
       if (!arg)
       {
@@ -60,7 +61,7 @@ CallExpression::Parse(token_stream& str,
 	 return nullptr;
       }
 
-      args.push_back(move(arg));
+      args.push_back(arg);
 
       //Don't need to eat; will have been done by
       //RHSExpression::Parse().
@@ -73,8 +74,8 @@ CallExpression::Parse(token_stream& str,
 	    //Eat )
 	    str.get();
 
-	    return make_unique<CallExpression>(curName,
-					       move(args));
+	    return info.GetArena().make<CallExpression>(curName,
+							info.GetArena().copy<Expression*>(args));
 	 }
 
 	 case token_kind::COMMA:
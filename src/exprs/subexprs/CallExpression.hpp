@@ -7,17 +7,19 @@
 class CallExpression : public Expression
 {
 private:
-   string name;
-   vector<unique_ptr<Expression>> args;
+   symbol name;
+   llvm::ArrayRef<Expression*> args; //In the arena
       
 public:
-   CallExpression(const string& funcName,
-		  vector<unique_ptr<Expression>> argsGiven);
+   CallExpression(symbol funcName,
+		  llvm::ArrayRef<Expression*> argsGiven);
 
-   ostream& print (ostream& stream) override;
+   ostream& print (ostream& stream, const Interner& names) override;
 
-   static unique_ptr<Expression> Parse(token_stream& str,
-				       ParseInfo info);
+   static Expression* Parse(token_stream& str,
+			    ParseInfo& info);
 
-   llvm::Value* Generate(ParseScope& scope, ParseBuild& build, ParseInfo info) override;
+   llvm::Value* Generate(ParseScope& scope, ParseBuild& build, ParseInfo& info) override;
+   flat_id Flatten(FlatTree& flat) override;
+   Expression* Fold(ParseFold& fold) override;
 };
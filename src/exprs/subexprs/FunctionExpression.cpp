@@ -3,33 +3,41 @@
 #include "SignatureExpression.hpp"
 #include "StatementExpression.hpp"
 
-FunctionExpression::FunctionExpression(unique_ptr<Expression> sig,
-				       vector<unique_ptr<Expression>>& stmts)
-   : signature (move(sig))
-   , statements (move(stmts))
+FunctionExpression::FunctionExpression(Expression* sig,
+				       llvm::ArrayRef<Expression*> stmts)
+   : signature (sig)
+   , statements (stmts)
 {
 }
 
 ostream&
-FunctionExpression::print (ostream& stream)
+FunctionExpression::print (ostream& stream, const Interner& names)
 {
    stream << "FunctionExpression: " << endl;
 
-   stream << "[Function signature:]" << endl << *signature;
+   stream << "[Function signature:]" << endl;
+   signature->print(stream, names);
 
    for (unsigned int i = 0; i < statements.size(); ++i)
    {
-      stream << "[Function statement " << i << ":]" << *statements[i];
+      stream << "[Function statement " << i << ":]";
+      statements[i]->print(stream, names);
    }
 
    return stream << endl << "FunctionExpression end" << endl;
 }
 
-unique_ptr<Expression>
+Expression*
+FunctionExpression::GetSignature() const
+{
+   return signature;
+}
+
+Expression*
 FunctionExpression::Parse(token_stream& str,
-			  ParseInfo info)
+			  ParseInfo& info)
 {
-   unique_ptr<Expression> sig = SignatureExpression::Parse(str, info);
+   Expression* sig = SignatureExpression::Parse(str, info);
 
    if (!sig)
    {
@@ -46,10 +54,8 @@ FunctionExpression::Parse(token_stream& str,
    str.get();
 
    //Parse body
-   vector<unique_ptr<Expression>> stmts;
+   llvm::SmallVector<Expression*, 16> stmts;
 
-   set<string> tempVars;
-   
    while (true)
    {
       if (str.cur_tok().GetKind() == token_kind::BRACE_CLOSE)
@@ -77,8 +83,8 @@ FunctionExpression::Parse(token_stream& str,
       //check if it's a base-level expression (declaration of
       //function, struct, etc.)
 
-      unique_ptr<Expression> stmt = StatementExpression::Parse(str,
-							       info);
+      Expression* stmt = StatementExpression::Parse(str,
+						    info);
 
       if (!stmt)
       {
@@ -113,13 +119,12 @@ FunctionExpression::Parse(token_stream& str,
 
 	TODO, one way or the other
       */
-      string lhs = stmt->GetSubject();
 
       //Scope checking currently done at Generate() level
       
-      stmts.push_back(move(stmt));
+      stmts.push_back(stmt);
    }
 
-   return make_unique<FunctionExpression>(move(sig),
-					  stmts);
+   return info.GetArena().make<FunctionExpression>(sig,
+						   info.GetArena().copy<Expression*>(stmts));
 }
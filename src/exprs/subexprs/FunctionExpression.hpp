@@ -11,17 +11,21 @@
 class FunctionExpression : public Expression
 {
 private:
-   unique_ptr<Expression> signature;
-   vector<unique_ptr<Expression>> statements;
+   Expression* signature;
+   llvm::ArrayRef<Expression*> statements; //In the arena
 
 public:
-   FunctionExpression(unique_ptr<Expression> sig,
-		      vector<unique_ptr<Expression>>& stmts);
+   FunctionExpression(Expression* sig,
+		      llvm::ArrayRef<Expression*> stmts);
 
-   ostream& print (ostream& stream) override;
+   ostream& print (ostream& stream, const Interner& names) override;
 
-   static unique_ptr<Expression> Parse(token_stream& str,
-				       ParseInfo info);
+   Expression* GetSignature() const;
+
+   static Expression* Parse(token_stream& str,
+			    ParseInfo& info);
    
-   llvm::Value* Generate(ParseScope& scope, ParseBuild& build, ParseInfo info) override;
+   llvm::Value* Generate(ParseScope& scope, ParseBuild& build, ParseInfo& info) override;
+   flat_id Flatten(FlatTree& flat) override;
+   Expression* Fold(ParseFold& fold) override;
 };
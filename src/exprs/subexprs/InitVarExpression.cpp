@@ -1,19 +1,27 @@
 #include "InitVarExpression.hpp"
 
-InitVarExpression::InitVarExpression(const string& varNm,
-				     const string& typNm)
+InitVarExpression::InitVarExpression(symbol varNm,
+				     symbol typNm)
    : varName (varNm)
    , typName (typNm)
 {
 }
 
-InitVarExpression::InitVarExpression(const string& varNm)
+InitVarExpression::InitVarExpression(symbol varNm)
    : varName (varNm)
+   , typName (Interner::none)
 {
 }
 
+symbol
+InitVarExpression::GetSubject()
+{
+   return varName;
+}
+
 ostream&
-InitVarExpression::print (ostream& stream)
+InitVarExpression::print (ostream& stream, const Interner& names)
 {
-   return stream << "InitVarExpression: " << typName << " " << varName << endl;
+   return stream << "InitVarExpression: " << names.name(typName).str() <<
+      " " << names.name(varName).str() << endl;
 }
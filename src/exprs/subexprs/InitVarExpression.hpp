@@ -13,18 +13,22 @@
 class InitVarExpression : public Expression
 {
 private:
-   string varName;
-   string typName;
+   symbol varName;
+   symbol typName;
 
 public:
-   InitVarExpression(const string& varNm,
-		     const string& typNm);
+   InitVarExpression(symbol varNm,
+		     symbol typNm);
 
    //TODO why is this available? Just notekeeping?
-   InitVarExpression(const string& varNm);
+   InitVarExpression(symbol varNm);
 
-   ostream& print (ostream& stream) override;
+   ostream& print (ostream& stream, const Interner& names) override;
 
-   llvm::Value* Generate(ParseScope& scope, ParseBuild& build, ParseInfo info) override;
-   llvm::Value* GenerateLHS(ParseScope& scope, ParseBuild& build, ParseInfo info) override;
+   llvm::Value* Generate(ParseScope& scope, ParseBuild& build, ParseInfo& info) override;
+   flat_id Flatten(FlatTree& flat) override;
+   Expression* Fold(ParseFold& fold) override;
+
+   symbol GetSubject() override;
+   llvm::Value* GenerateLHS(ParseScope& scope, ParseBuild& build, ParseInfo& info) override;
 };
@@ -0,0 +1,35 @@
+#include "LitFloatExpression.hpp"
+
+LitFloatExpression::LitFloatExpression(float val)
+   : value (val)
+{
+}
+
+ostream&
+LitFloatExpression::print (ostream& stream, const Interner& names)
+{
+   return stream << "LitFloatExpression: " << value << endl;
+}
+
+Expression*
+LitFloatExpression::Parse(token_stream& str,
+			  ParseInfo& info)
+{
+   float result;
+
+   if (info.get_literal_float(str.cur_tok().GetValue().str(), result))
+   {
+      //Eat literal
+      str.get();
+      
+      return info.GetArena().make<LitFloatExpression>(result);
+   }
+
+   else
+   {
+      Log::log_error(Error(0, 0,
+			   string("Invalid float literal.")));
+      
+      return nullptr;
+   }
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "../Expression.hpp"
+
+#include <iostream>
+
+class LitFloatExpression : public Expression
+{
+private:
+   float value;
+   
+public:
+   LitFloatExpression(float val);
+
+   ostream& print (ostream& stream, const Interner& names) override;
+   
+   static Expression* Parse(token_stream& str,
+			    ParseInfo& info);
+   
+   llvm::Value* Generate(ParseScope& scope, ParseBuild& build, ParseInfo& info) override;
+   flat_id Flatten(FlatTree& flat) override;
+};
@@ -6,23 +6,23 @@ LitIntExpression::LitIntExpression(int val)
 }
 
 ostream&
-LitIntExpression::print (ostream& stream)
+LitIntExpression::print (ostream& stream, const Interner& names)
 {
    return stream << "LitIntExpression: " << value << endl;
 }
 
-unique_ptr<Expression>
+Expression*
 LitIntExpression::Parse(token_stream& str,
-			ParseInfo info)
+			ParseInfo& info)
 {
    int result;
 
-   if (info.get_literal_int(str.cur_tok().GetValue(), result))
+   if (info.get_literal_int(str.cur_tok().GetValue().str(), result))
    {
       //Eat literal
       str.get();
       
-      return std::make_unique<LitIntExpression>(result);
+      return info.GetArena().make<LitIntExpression>(result);
    }
 
    else
@@ -12,10 +12,14 @@ private:
 public:
    LitIntExpression(int val);
 
-   ostream& print (ostream& stream) override;
+   ostream& print (ostream& stream, const Interner& names) override;
    
-   static unique_ptr<Expression> Parse(token_stream& str,
-				       ParseInfo info);
+   static Expression* Parse(token_stream& str,
+			    ParseInfo& info);
    
-   llvm::Value* Generate(ParseScope& scope, ParseBuild& build, ParseInfo info) override;
+   llvm::Value* Generate(ParseScope& scope, ParseBuild& build, ParseInfo& info) override;
+   flat_id Flatten(FlatTree& flat) override;
+   Expression* Fold(ParseFold& fold) override;
+   bool GetLitInt(int& val) const override;
+   bool IsInt(const ParseFold& fold) const override;
 };
@@ -0,0 +1,161 @@
+#include "LoopExpression.hpp"
+
+#include "RHSExpression.hpp"
+#include "StatementExpression.hpp"
+
+LoopExpression::LoopExpression(Expression* in, Expression* cnd, Expression* stp,
+			       llvm::ArrayRef<Expression*> stmts)
+   : init (in)
+   , cond (cnd)
+   , step (stp)
+   , body (stmts)
+{
+}
+
+ostream&
+LoopExpression::print (ostream& stream, const Interner& names)
+{
+   stream << "LoopExpression: " << endl;
+
+   if (init)
+   {
+      stream << "[Loop init:]" << endl;
+      init->print(stream, names);
+   }
+
+   stream << "[Loop condition:]" << endl;
+   cond->print(stream, names);
+
+   if (step)
+   {
+      stream << "[Loop step:]" << endl;
+      step->print(stream, names);
+   }
+
+   for (unsigned int i = 0; i < body.size(); ++i)
+   {
+      stream << "[Loop statement " << i << ":]";
+      body[i]->print(stream, names);
+   }
+
+   return stream << "LoopExpression end" << endl;
+}
+
+Expression*
+LoopExpression::Parse(token_stream& str,
+		      ParseInfo& info)
+{
+   Expression* in = nullptr;
+   Expression* stp = nullptr;
+
+   bool isFor = (str.cur_tok().GetKind() == token_kind::KEY_FOR);
+
+   //Eat for/while
+   str.get();
+
+   if (isFor)
+   {
+      //Only an assign, init or call; not a return or another loop
+      in = StatementExpression::ParseSimple(str, info);
+
+      if (!in)
+      {
+	 Log::log_error(Error(0, 0,
+			      string("Failure parsing the start of a for loop.")));
+	 return nullptr;
+      }
+
+      if (str.cur_tok().GetKind() != token_kind::SEMICOLON)
+      {
+	 Log::log_error(Error(0, 0,
+			      string("Expected ; after the start of a for loop.")));
+	 return nullptr;
+      }
+
+      //Eat ;
+      str.get();
+   }
+
+   Expression* cnd = RHSExpression::Parse(str, info);
+
+   if (!cnd)
+   {
+      Log::log_error(Error(0, 0,
+			   string("Failure parsing a loop's condition.")));
+      return nullptr;
+   }
+
+   if (isFor)
+   {
+      if (str.cur_tok().GetKind() != token_kind::SEMICOLON)
+      {
+	 Log::log_error(Error(0, 0,
+			      string("Expected ; after a for loop's condition.")));
+	 return nullptr;
+      }
+
+      //Eat ;
+      str.get();
+
+      stp = StatementExpression::ParseSimple(str, info);
+
+      if (!stp)
+      {
+	 Log::log_error(Error(0, 0,
+			      string("Failure parsing the step of a for loop.")));
+	 return nullptr;
+      }
+   }
+
+   if (str.cur_tok().GetKind() != token_kind::BRACE_OPEN)
+   {
+      Log::log_error(Error(0, 0,
+			   string("Expected a { to open a loop's body.")));
+      return nullptr;
+   }
+
+   //Eat {
+   str.get();
+
+   llvm::SmallVector<Expression*, 16> stmts;
+
+   //A return ends the body's block, so nothing can come after it
+   bool returned = false;
+
+   while (str.cur_tok().GetKind() != token_kind::BRACE_CLOSE)
+   {
+      if (str.cur_tok().GetKind() == token_kind::END)
+      {
+	 Log::log_error(Error(0, 0,
+			      string("Expected a }; got end of file.")));
+
+	 return nullptr;
+      }
+
+      if (returned)
+      {
+	 Log::log_error(Error(0, 0,
+			      string("A statement after a return in a loop's body.")));
+	 return nullptr;
+      }
+
+      returned = (str.cur_tok().GetKind() == token_kind::KEY_RETURN);
+
+      Expression* stmt = StatementExpression::Parse(str, info);
+
+      if (!stmt)
+      {
+	 Log::log_error(Error(0, 0,
+			      string("Failure parsing statement.")));
+	 return nullptr;
+      }
+
+      stmts.push_back(stmt);
+   }
+
+   //Eat }
+   str.get();
+
+   return info.GetArena().make<LoopExpression>(in, cnd, stp,
+					       info.GetArena().copy<Expression*>(stmts));
+}
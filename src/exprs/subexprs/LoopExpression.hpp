@@ -0,0 +1,38 @@
+#pragma once
+
+#include "../Expression.hpp"
+
+/*
+  A for or while loop:
+
+  for int i = 0; i < n; i = i + 1 { ... }
+  while i < n { ... }
+
+  A while is a for with no init or step. The init's names are scoped
+  to the loop, and the body's to each time round it. Generated as a
+  canonical loop (see LoopExpression::Generate()), so LLVM's loop
+  passes can get at it.
+*/
+
+class LoopExpression : public Expression
+{
+private:
+   Expression* init; //nullptr for a while
+   Expression* cond;
+   Expression* step; //nullptr for a while
+   llvm::ArrayRef<Expression*> body; //In the arena
+
+public:
+   LoopExpression(Expression* in, Expression* cnd, Expression* stp,
+		  llvm::ArrayRef<Expression*> stmts);
+
+   ostream& print (ostream& stream, const Interner& names) override;
+
+   //From the for or while
+   static Expression* Parse(token_stream& str,
+			    ParseInfo& info);
+
+   flat_id Flatten(FlatTree& flat) override;
+   llvm::Value* Generate(ParseScope& scope, ParseBuild& build, ParseInfo& info) override;
+   Expression* Fold(ParseFold& fold) override;
+};
@@ -3,9 +3,9 @@
 #include "VarExpression.hpp"
 #include "CallExpression.hpp"
 
-unique_ptr<Expression>
+Expression*
 NameExpression::Parse(token_stream& str,
-		      ParseInfo info)
+		      ParseInfo& info)
 {
    //either a VarExpression or a function call. Should only be on the
    //rhs of an assign (not an assign ref).
@@ -9,6 +9,6 @@
 class NameExpression : public Expression
 {
 public:
-   static unique_ptr<Expression> Parse(token_stream& str,
-				       ParseInfo info);
+   static Expression* Parse(token_stream& str,
+			    ParseInfo& info);
 };
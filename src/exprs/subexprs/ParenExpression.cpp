@@ -2,9 +2,9 @@
 
 #include "RHSExpression.hpp"
 
-unique_ptr<Expression>
+Expression*
 ParenExpression::Parse(token_stream& str,
-		       ParseInfo info)
+		       ParseInfo& info)
 {
    //TODO: might have to add case of tuples, I mean '(int, int) = ...'
 
@@ -13,12 +13,10 @@ ParenExpression::Parse(token_stream& str,
    //Eat (
    str.get();
 
-   unique_ptr<Expression> enclosed = RHSExpression::Parse(str,
-							  info);
+   Expression* enclosed = RHSExpression::Parse(str,
+					       info);
 
-   //Eat )
-   str.get();
-   
+   //(RHSExpression::Parse leaves the ) current)
    if (str.cur_tok().GetKind() != token_kind::PAREN_CLOSE)
    {
       Log::log_error(Error(0, 0,
@@ -27,6 +25,9 @@ ParenExpression::Parse(token_stream& str,
       return nullptr;
    }
 
+   //Eat )
+   str.get();
+
    if (!enclosed)
    {
       Log::log_error(Error(0, 0,
@@ -10,6 +10,6 @@
 class ParenExpression : public Expression
 {
 public:
-   static unique_ptr<Expression> Parse(token_stream& str,
-				       ParseInfo info);
+   static Expression* Parse(token_stream& str,
+			    ParseInfo& info);
 };
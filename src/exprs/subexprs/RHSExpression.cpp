@@ -2,18 +2,41 @@
 
 #include "ParenExpression.hpp"
 #include "LitIntExpression.hpp"
+#include "LitFloatExpression.hpp"
 #include "NameExpression.hpp"
 #include "BinaryExpression.hpp"
 
-unique_ptr<Expression>
+Expression*
 RHSExpression::Parse(token_stream& str,
-		     ParseInfo info)
+		     ParseInfo& info)
 {
    //NB: don't assume it's ended by a semicolon; these expressions are
    //just meant to be value-reducible and might, e.g., be delimited by commas.
 
    //Wrapper for (potential) binary op
-   unique_ptr<Expression> cur = nullptr;
+   Expression* cur = ParseOperand(str, info);
+
+   if (!cur)
+      return nullptr;
+
+   //Check if op next (no get() because of above Parse()s)
+   
+   if (info.get_binary_precedence(str.cur_tok().GetKind()))
+   {
+      //BinaryExpression::Parse takes every op (and operand) up to the
+      //end of the RHS
+      return BinaryExpression::Parse(str, info,
+				     cur);
+   }
+
+   else return cur;
+}
+
+Expression*
+RHSExpression::ParseOperand(token_stream& str,
+			    ParseInfo& info)
+{
+   Expression* cur = nullptr;
    
    //First symbol
    switch (str.cur_tok().GetKind())
@@ -24,6 +47,12 @@ RHSExpression::Parse(token_stream& str,
       }
       break;
 
+      case token_kind::LIT_FLOAT:
+      {
+	 cur = LitFloatExpression::Parse(str, info);
+      }
+      break;
+
    //TODO: other literals
 
       case token_kind::PAREN_OPEN:
@@ -46,18 +75,7 @@ RHSExpression::Parse(token_stream& str,
    {
       Log::log_error(Error(0, 0,
 			   string("Failure parsing value-reducible expression.")));
-      return nullptr;
    }
 
-   //Check if op next (no get() because of above Parse()s)
-   
-   if (info.get_binary_precedence(str.cur_tok()))
-   {
-      //Binary ops are already recursive; it should go to the end of
-      //the RHS
-      return BinaryExpression::Parse(str, info,
-				     move(cur));
-   }
-
-   else return cur;
+   return cur;
 }
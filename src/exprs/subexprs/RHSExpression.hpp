@@ -19,6 +19,11 @@
 class RHSExpression : public Expression
 {
 public:
-   static unique_ptr<Expression> Parse(token_stream& str,
-				       ParseInfo info);
+   static Expression* Parse(token_stream& str,
+			    ParseInfo& info);
+
+   //Just a single operand: a literal, name, call or parenthesised
+   //expression, without any binary ops after it
+   static Expression* ParseOperand(token_stream& str,
+				   ParseInfo& info);
 };
@@ -2,31 +2,32 @@
 
 #include "RHSExpression.hpp"
 
-ReturnExpression::ReturnExpression(vector<unique_ptr<Expression>> rs)
-   : rets (move(rs))
+ReturnExpression::ReturnExpression(llvm::ArrayRef<Expression*> rs)
+   : rets (rs)
 {
 }
 
 ostream&
-ReturnExpression::print (ostream& stream)
+ReturnExpression::print (ostream& stream, const Interner& names)
 {
    stream << "ReturnExpression: " << endl;
 
    for (unsigned int i = 0; i < rets.size(); ++i)
    {
-      stream << "[Return " << i << ":]" << endl << *rets[i];
+      stream << "[Return " << i << ":]" << endl;
+      rets[i]->print(stream, names);
    }
 
    return stream << "ReturnExpression end" << endl;
 }
 
-unique_ptr<Expression> ReturnExpression::Parse(token_stream& str,
-					       ParseInfo info)
+Expression* ReturnExpression::Parse(token_stream& str,
+					       ParseInfo& info)
 {
    //Eat 'return'
    str.get();
 
-   vector<unique_ptr<Expression>> rs;
+   llvm::SmallVector<Expression*, 4> rs;
    
    while (str.cur_tok().GetKind() != token_kind::SEMICOLON)
    {
@@ -38,12 +39,12 @@ unique_ptr<Expression> ReturnExpression::Parse(token_stream& str,
 	 continue;
       }
       
-      unique_ptr<Expression> cur = RHSExpression::Parse(str,
-							info);
+      Expression* cur = RHSExpression::Parse(str,
+					     info);
 
       if (cur)
       {
-	 rs.push_back(move(cur));
+	 rs.push_back(cur);
       }
 
       else
@@ -57,5 +58,5 @@ unique_ptr<Expression> ReturnExpression::Parse(token_stream& str,
    //Eat semicolon
    str.get();
 
-   return make_unique<ReturnExpression>(move(rs));
+   return info.GetArena().make<ReturnExpression>(info.GetArena().copy<Expression*>(rs));
 }
@@ -9,15 +9,17 @@
 class ReturnExpression : public Expression
 {
 private:
-   vector<unique_ptr<Expression>> rets;
+   llvm::ArrayRef<Expression*> rets; //In the arena
 
 public:
-   ReturnExpression(vector<unique_ptr<Expression>> rs);
+   ReturnExpression(llvm::ArrayRef<Expression*> rs);
    
-   static unique_ptr<Expression> Parse(token_stream& str,
-				       ParseInfo info);
+   static Expression* Parse(token_stream& str,
+			    ParseInfo& info);
    
-   llvm::Value* Generate(ParseScope& scope, ParseBuild& build, ParseInfo info) override;
+   llvm::Value* Generate(ParseScope& scope, ParseBuild& build, ParseInfo& info) override;
+   flat_id Flatten(FlatTree& flat) override;
+   Expression* Fold(ParseFold& fold) override;
 
-   ostream& print (ostream& stream) override;
+   ostream& print (ostream& stream, const Interner& names) override;
 };
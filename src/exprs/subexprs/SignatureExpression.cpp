@@ -2,31 +2,32 @@
 
 
 
-SignatureExpression::SignatureExpression(const string& name,
-					 vector<string> rs,
-					 vector<tuple<string, string>> args)
+SignatureExpression::SignatureExpression(symbol name,
+					 llvm::ArrayRef<symbol> rs,
+					 llvm::ArrayRef<tuple<symbol, symbol>> args)
    : funcName (name)
-   , rets (move(rs))
-   , params (move(args))
+   , rets (rs)
+   , params (args)
 {
 }
 
 ostream&
-SignatureExpression::print (ostream& stream)
+SignatureExpression::print (ostream& stream, const Interner& names)
 {
-   stream << "SignatureExpression: " << funcName << endl;
+   stream << "SignatureExpression: " << names.name(funcName).str() << endl;
 
    for (unsigned int i = 0; i < rets.size(); ++i)
    {
-      stream << "[Signature return " << i << ":]" << endl << rets[i];
+      stream << "[Signature return " << i << ":]" << endl << names.name(rets[i]).str();
    }
 
    stream << endl;
 
-   for (unsigned int i = 0; i < rets.size(); ++i)
+   for (unsigned int i = 0; i < params.size(); ++i)
    {
       stream << "[Signature param " << i << ":]" <<
-	 get<0>(params[i]) << " " << get<1>(params[i]) << endl;
+	 names.name(get<0>(params[i])).str() << " " <<
+	 names.name(get<1>(params[i])).str() << endl;
    }
 
    stream << endl;
@@ -34,13 +35,25 @@ SignatureExpression::print (ostream& stream)
    return stream << "SignatureExpression end" << endl;
 }
 
-string
+symbol
 SignatureExpression::GetFuncName() const
 {
    return funcName;
 }
 
-string
+llvm::ArrayRef<symbol>
+SignatureExpression::GetRets() const
+{
+   return rets;
+}
+
+llvm::ArrayRef<tuple<symbol, symbol>>
+SignatureExpression::GetParams() const
+{
+   return params;
+}
+
+symbol
 SignatureExpression::GetParamName(size_t index)
 {
    return get<1>(params[index]);
@@ -50,23 +63,23 @@ SignatureExpression::GetParamName(size_t index)
 token_kind
 SignatureExpression::GetParamType(size_t index) const
 {
-   const string& typeName = get<0>(params[index]);
-
-   if (typeName == "int")
-      return token_kind::TYPE_INT;
+   token_kind typeKind = Interner::builtin_kind(get<0>(params[index]));
 
-   if (typeName == "float")
-      return token_kind::TYPE_FLOAT;
-
-   if (typeName == "string")
-      return token_kind::TYPE_STRING;
+   switch (typeKind)
+   {
+      case token_kind::TYPE_INT:
+      case token_kind::TYPE_FLOAT:
+      case token_kind::TYPE_STRING:
+	 return typeKind;
 
-   else return token_kind::INVALID;
+      default:
+	 return token_kind::INVALID;
+   }
 }
 
 //ie has this name for a param already been used as a name for a param?
 bool
-SignatureExpression::IsParam(string paramName) const
+SignatureExpression::IsParam(symbol paramName) const
 {
    for (unsigned int i = 0; i < params.size(); ++i)
    {
@@ -85,14 +98,14 @@ SignatureExpression::IsVoid() const
    return !rets.size();
 }
 
-unique_ptr<Expression>
+Expression*
 SignatureExpression::Parse(token_stream& str,
-			   ParseInfo info)
+			   ParseInfo& info)
 {
-   vector<string> rs;
-   vector<tuple<string, string>> args;
+   llvm::SmallVector<symbol, 4> rs;
+   llvm::SmallVector<tuple<symbol, symbol>, 8> args;
 
-   string name;
+   symbol name;
 
    //Return values, and function name
 
@@ -121,7 +134,7 @@ SignatureExpression::Parse(token_stream& str,
 		  return nullptr;
 	       }
 
-	       rs.push_back(str.cur_tok().GetValue());
+	       rs.push_back(str.cur_tok().GetSymbol());
 
 	       //Eat type
 	       str.get();
@@ -138,7 +151,7 @@ SignatureExpression::Parse(token_stream& str,
 
 	    case token_kind::TYPE_INT:
 	    {
-	       rs.emplace_back("int");
+	       rs.push_back(str.cur_tok().GetSymbol());
 	       
 	       str.get();
 	    }
@@ -146,7 +159,7 @@ SignatureExpression::Parse(token_stream& str,
 
 	    case token_kind::TYPE_FLOAT:
 	    {
-	       rs.emplace_back("float");
+	       rs.push_back(str.cur_tok().GetSymbol());
 	       
 	       str.get();
 	    }
@@ -154,7 +167,7 @@ SignatureExpression::Parse(token_stream& str,
 
 	    case token_kind::TYPE_STRING:
 	    {
-	       rs.emplace_back("string");
+	       rs.push_back(str.cur_tok().GetSymbol());
 	       
 	       str.get();
 	    }
@@ -213,19 +226,19 @@ SignatureExpression::Parse(token_stream& str,
 	 
 	 case token_kind::TYPE_INT:
 	 {
-	    rs.emplace_back("int");
+	    rs.push_back(str.cur_tok().GetSymbol());
 	    break;
 	 }
 
 	 case token_kind::TYPE_FLOAT:
 	 {
-	    rs.emplace_back("float");
+	    rs.push_back(str.cur_tok().GetSymbol());
 	    break;
 	 }
 
 	 case token_kind::TYPE_STRING:
 	 {
-	    rs.emplace_back("string");
+	    rs.push_back(str.cur_tok().GetSymbol());
 	    break;
 	 }
 
@@ -238,7 +251,7 @@ SignatureExpression::Parse(token_stream& str,
 	       return nullptr;
 	    }
 
-	    rs.push_back(str.cur_tok().GetValue());
+	    rs.push_back(str.cur_tok().GetSymbol());
 	    break;
 	 }
 
@@ -255,8 +268,10 @@ SignatureExpression::Parse(token_stream& str,
       str.get();
    }
 
-   //Either way, function name is next
-   if (str.cur_tok().GetKind() != token_kind::NAME)
+   //Either way, function name is next. 'main' lexes as a keyword, but
+   //it's just a name here
+   if ((str.cur_tok().GetKind() != token_kind::NAME) &&
+       (str.cur_tok().GetKind() != token_kind::KEY_MAIN))
    {
       Log::log_error(Error(0, 0,
 			   string("Expected function name after return list.")));
@@ -271,7 +286,7 @@ SignatureExpression::Parse(token_stream& str,
    }
 
    //Save name for later
-   name = str.cur_tok().GetValue();
+   name = str.cur_tok().GetSymbol();
 
    //Eat function name
    str.get();
@@ -305,7 +320,7 @@ SignatureExpression::Parse(token_stream& str,
       }
 
       //Eat a type name
-      const string& typeName = str.cur_tok().GetValue();
+      symbol typeName = str.cur_tok().GetSymbol();
 
       str.get();
 
@@ -317,8 +332,8 @@ SignatureExpression::Parse(token_stream& str,
 	 return nullptr;
       }
 
-      args.push_back(tuple<string, string>(typeName,
-					   str.cur_tok().GetValue()));
+      args.push_back(tuple<symbol, symbol>(typeName,
+					   str.cur_tok().GetSymbol()));
 
       //Eat name
       str.get();
@@ -348,5 +363,7 @@ SignatureExpression::Parse(token_stream& str,
       }
    }
 
-   return make_unique<SignatureExpression>(name, rs, args);
+   return info.GetArena().make<SignatureExpression>(name,
+						    info.GetArena().copy<symbol>(rs),
+						    info.GetArena().copy<tuple<symbol, symbol>>(args));
 }
@@ -12,31 +12,35 @@ private:
    //Name goes here bc you could define (and then parse) the sig
    //without the body. Whereas the body will never be defined without
    //an accompanying sig to parse.
-   string funcName;
+   symbol funcName;
 
-   vector<string> rets;
-   vector<tuple<string, string>> params;
+   //Type names; and type and param names (both in the arena)
+   llvm::ArrayRef<symbol> rets;
+   llvm::ArrayRef<tuple<symbol, symbol>> params;
 
 public:
-   SignatureExpression(const string& name,
-		       vector<string> rs,
-		       vector<tuple<string, string>> args);
+   SignatureExpression(symbol name,
+		       llvm::ArrayRef<symbol> rs,
+		       llvm::ArrayRef<tuple<symbol, symbol>> args);
 
-   ostream& print (ostream& stream) override;
+   ostream& print (ostream& stream, const Interner& names) override;
 
-   static unique_ptr<Expression> Parse(token_stream& str,
-				       ParseInfo info);
+   static Expression* Parse(token_stream& str,
+			    ParseInfo& info);
    
-   llvm::Function* Generate(ParseScope& scope, ParseBuild& build, ParseInfo info) override;
+   llvm::Function* Generate(ParseScope& scope, ParseBuild& build, ParseInfo& info) override;
+   flat_id Flatten(FlatTree& flat) override;
 
-   string GetFuncName() const override;
-   string GetParamName(size_t index) override;
+   symbol GetFuncName() const override;
+   llvm::ArrayRef<symbol> GetRets() const;
+   llvm::ArrayRef<tuple<symbol, symbol>> GetParams() const;
+   symbol GetParamName(size_t index) override;
 
    //TODO: will have to be changed for custom types...
    token_kind GetParamType(size_t index) const override;
 
    //ie has this name for a param already been used as a name for a param?
-   bool IsParam(string paramName) const override;
+   bool IsParam(symbol paramName) const override;
 
    bool IsVoid() const override;
 };
@@ -5,9 +5,10 @@
 #include "InitVarExpression.hpp"
 #include "VarExpression.hpp"
 #include "CallExpression.hpp"
+#include "LoopExpression.hpp"
 
-unique_ptr<Expression> StatementExpression::Parse(token_stream& str,
-						  ParseInfo info)
+Expression* StatementExpression::Parse(token_stream& str,
+						  ParseInfo& info)
 {
    //This function is the main one that checks SEMICOLONs.
 
@@ -16,7 +17,41 @@ unique_ptr<Expression> StatementExpression::Parse(token_stream& str,
       return ReturnExpression::Parse(str, info);
    }
 
-   unique_ptr<Expression> stmt = nullptr;
+   //Loops end with their body's }, not a ;
+   if ((str.cur_tok().GetKind() == token_kind::KEY_FOR) or
+       (str.cur_tok().GetKind() == token_kind::KEY_WHILE))
+   {
+      return LoopExpression::Parse(str, info);
+   }
+
+   Expression* stmt = ParseSimple(str, info);
+
+   if (!stmt)
+      return nullptr;
+
+   //Check semicolon at end
+   if (str.cur_tok().GetKind() != token_kind::SEMICOLON)
+   {
+      Log::log_error(Error(0, 0,
+			   string("Expected ; closing statement.")));
+
+      //TODO remove
+      cout << str.cur_tok();//
+      //
+      
+      return nullptr;
+   }
+
+   //Eat ;
+   str.get();
+	    
+   return stmt;
+}
+
+Expression* StatementExpression::ParseSimple(token_stream& str,
+					     ParseInfo& info)
+{
+   Expression* stmt = nullptr;
    
    /*
      If not control flow, must be an assign, init, or call
@@ -25,9 +60,9 @@ unique_ptr<Expression> StatementExpression::Parse(token_stream& str,
      check for naming rules, which might be different from variable
      name rules.
 
-     Following is single-exit for clarity; semicolons checked at the end.
-     (Return, on the other hand, is helped by its own semicolon
-     checking.)
+     Following is single-exit for clarity; semicolons are checked by
+     Parse(). (Return, on the other hand, is helped by its own
+     semicolon checking.)
 
      TODO: temporary and misleading. is_type_token only
      coincidentally checks assigns without init-vars, because
@@ -45,7 +80,7 @@ unique_ptr<Expression> StatementExpression::Parse(token_stream& str,
       else //Not a call; init or assign
       {
 	 token nmTok = str.cur_tok();
-	 const string nm = str.cur_tok().GetValue();
+	 const llvm::StringRef nm = str.cur_tok().GetValue();
 
 	 //Eat type/variable name
 	 str.get();
@@ -68,8 +103,8 @@ unique_ptr<Expression> StatementExpression::Parse(token_stream& str,
 		  //It's a var
 		  //TODO: see below, else clause
 		  stmt = AssignExpression::Parse(str, info,
-						 make_unique<VarExpression>(nm,
-									    string()));
+						 info.GetArena().make<VarExpression>(nmTok.GetSymbol(),
+										     Interner::none));
 	       }
 
 	       //TODO else value assignment to ref alternative
@@ -110,12 +145,12 @@ unique_ptr<Expression> StatementExpression::Parse(token_stream& str,
 	       case token_kind::TYPE_STRING:
 	       {
 		  //It's a var
-		  const string varNm = str.cur_tok().GetValue();
+		  symbol varNm = str.cur_tok().GetSymbol();
 
 		  //Eat var name
 		  str.get();
 	       
-		  stmt = make_unique<InitVarExpression>(varNm, nm);
+		  stmt = info.GetArena().make<InitVarExpression>(varNm, nmTok.GetSymbol());
 
 		  break;
 	       }
@@ -134,13 +169,13 @@ unique_ptr<Expression> StatementExpression::Parse(token_stream& str,
 		  if (nm[nm.size() - 1] != '\'')
 		  {
 		     //It's a var	 
-		     const string varNm = str.cur_tok().GetValue();
+		     symbol varNm = str.cur_tok().GetSymbol();
 
 		     //Eat var name
 		     str.get();
 	 
 		     //Don't really need the Parse tbh
-		     stmt = make_unique<InitVarExpression>(varNm, nm);
+		     stmt = info.GetArena().make<InitVarExpression>(varNm, nmTok.GetSymbol());
 		  }
 
 		  //TODO else InitRefExpression...
@@ -165,7 +200,7 @@ unique_ptr<Expression> StatementExpression::Parse(token_stream& str,
 	       //VarRef, RefVar etc. ambiguities. This only works now
 	       //because of no refs
 	       stmt = AssignExpression::Parse(str, info,
-					      move(stmt));
+					      stmt);
 	    }
 
 	    //TODO else ref_assign
@@ -183,21 +218,5 @@ unique_ptr<Expression> StatementExpression::Parse(token_stream& str,
       return nullptr;
    }
 
-   //Check semicolon at end
-   if (str.cur_tok().GetKind() != token_kind::SEMICOLON)
-   {
-      Log::log_error(Error(0, 0,
-			   string("Expected ; closing statement.")));
-
-      //TODO remove
-      cout << str.cur_tok();//
-      //
-      
-      return nullptr;
-   }
-
-   //Eat ;
-   str.get();
-	    
    return stmt;
 }
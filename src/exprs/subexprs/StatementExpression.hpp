@@ -12,6 +12,9 @@
 class StatementExpression : public Expression
 {
 public:
-   static unique_ptr<Expression> Parse(token_stream& str,
-				       ParseInfo info);
+   static Expression* Parse(token_stream& str,
+			    ParseInfo& info);
+   //An assign, init or call, without the ; (as in a for's header)
+   static Expression* ParseSimple(token_stream& str,
+				  ParseInfo& info);
 };
@@ -1,35 +1,36 @@
 #include "VarExpression.hpp"
 
-VarExpression::VarExpression(const string& varNm)
+VarExpression::VarExpression(symbol varNm)
    : varName (varNm)
+   , typeName (Interner::none)
 {
 }
 
-VarExpression::VarExpression(const string& varNm,
-			     const string& typeNm)
+VarExpression::VarExpression(symbol varNm,
+			     symbol typeNm)
    : varName (varNm)
    , typeName (typeNm)
 {
 }
 
 ostream&
-VarExpression::print (ostream& stream)
+VarExpression::print (ostream& stream, const Interner& names)
 {
-   return stream << "VarExpression: " << varName <<
-      ", type: " << typeName << endl;
+   return stream << "VarExpression: " << names.name(varName).str() <<
+      ", type: " << names.name(typeName).str() << endl;
 }
 
-string
+symbol
 VarExpression::GetSubject()
 {
    return varName;
 }
 
-unique_ptr<Expression>
+Expression*
 VarExpression::Parse(token_stream& str,
-		     ParseInfo info)
+		     ParseInfo& info)
 {
-   const string& name = str.cur_tok().GetValue();
+   symbol name = str.cur_tok().GetSymbol();
 
    //Eat NAME
    str.get();
@@ -37,5 +38,5 @@ VarExpression::Parse(token_stream& str,
    //TODO: Check validity of name before committing to construction?
    //or in the lexer?
 
-   return make_unique<VarExpression>(name);
+   return info.GetArena().make<VarExpression>(name);
 }
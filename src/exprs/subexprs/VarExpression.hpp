@@ -34,28 +34,32 @@
 class VarExpression : public Expression
 {
 private:
-   string varName;
-   string typeName;
+   symbol varName;
+   symbol typeName;
       
 public:
-   VarExpression(const string& varNm);
-   VarExpression(const string& varNm,
-		 const string& typeNm);
+   VarExpression(symbol varNm);
+   VarExpression(symbol varNm,
+		 symbol typeNm);
 
-   ostream& print (ostream& stream) override;
+   ostream& print (ostream& stream, const Interner& names) override;
 
-   static unique_ptr<Expression> Parse(token_stream& str,
-				       ParseInfo info);
+   static Expression* Parse(token_stream& str,
+			    ParseInfo& info);
 
    llvm::Value* Generate(ParseScope& scope,
 			 ParseBuild& build,
-			 ParseInfo info) override;
+			 ParseInfo& info) override;
    llvm::Value* GenerateLHS(ParseScope& scope,
 			 ParseBuild& build,
-			 ParseInfo info) override;
+			 ParseInfo& info) override;
    llvm::Value* GenerateRHS(ParseScope& scope,
 			 ParseBuild& build,
-			 ParseInfo info) override;
+			 ParseInfo& info) override;
+   flat_id Flatten(FlatTree& flat) override;
+   Expression* Fold(ParseFold& fold) override;
+   Expression* FoldLHS(ParseFold& fold) override;
+   bool IsInt(const ParseFold& fold) const override;
 
-   string GetSubject() override;
+   symbol GetSubject() override;
 };
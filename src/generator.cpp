@@ -1,12 +1,20 @@
 #include "Parser.hpp"
 #include "log.hpp"
 
+#include "llvm/IR/Intrinsics.h"
 #include "llvm/IR/Verifier.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/Linker/Linker.h"
+
+#include <functional>
+#include <thread>
 
 //Here and eg in subexpr .cpp files subexprs are included to use their
 //static functions/make_uniques without incurring cost of including in .hpps.
 #include "exprs/subexprs/VarExpression.hpp"
 #include "exprs/subexprs/LitIntExpression.hpp"
+#include "exprs/subexprs/LitFloatExpression.hpp"
 #include "exprs/subexprs/NameExpression.hpp"
 #include "exprs/subexprs/BinaryExpression.hpp"
 #include "exprs/subexprs/StatementExpression.hpp"
@@ -18,47 +26,62 @@
 #include "exprs/subexprs/ParenExpression.hpp"
 #include "exprs/subexprs/AssignExpression.hpp"
 #include "exprs/subexprs/InitVarExpression.hpp"
+#include "exprs/subexprs/LoopExpression.hpp"
 
-void Parser::Generate()
-{
-   for (unsigned int i = 0; i < parsed.size(); ++i)
-   {
-      generated.push_back(parsed[i]->Generate(scope, build, ParseInfo(build)));
-   }
-}
+/*
+  The parts of generation that don't depend on how the tree is laid
+  out. Each is given a node's fields, and whichever of its children
+  have already been generated; the Expression tree's Generate()s and
+  FlatTree's both go through these, so the two give the same IR.
+*/
 
-llvm::Value* LitIntExpression::Generate(ParseScope& scope, ParseBuild& build, ParseInfo info)
+static llvm::Value*
+generate_lit_int(ParseBuild& build, int value)
 {
    return llvm::ConstantInt::get(build.GetContext(),
 				 llvm::APInt(32, (uint64_t) value));
 				 //Must also specify if signed
 }
 
-llvm::Value* VarExpression::Generate(ParseScope& scope, ParseBuild& build, ParseInfo info)
+static llvm::Value*
+generate_lit_float(ParseBuild& build, float value)
 {
-   //By default return value, not pointer; exceptions won't call
-   //Generate, but GenerateLHS.
-   return GenerateRHS(scope, build, info);
+   return llvm::ConstantFP::get(llvm::Type::getFloatTy(build.GetContext()), value);
 }
 
-llvm::Value* VarExpression::GenerateLHS(ParseScope& scope, ParseBuild& build, ParseInfo info)
+/*
+  val as a typ, where an int's wanted as a float or the other way
+  round, as C converts them (floats towards 0); and a bool (from a
+  comparison) as 0 or 1. Anything else is left as it is.
+*/
+static llvm::Value*
+generate_convert(ParseBuild& build, llvm::Value* val, llvm::Type* typ)
 {
-   llvm::AllocaInst* addr = scope.is_in_scope(varName);
+   llvm::Type* from = val->getType();
 
-   if (!addr)
+   if (from == typ)
+      return val;
+
+   if (from->isIntegerTy(1))
    {
-      Log::log_error(Error(0, 0,
-			   string("Variable name '" +
-				  varName +
-				  "' not in scope.")));
-      return nullptr;
+      if (typ->isIntegerTy())
+	 return build.GetBuilder().CreateZExt(val, typ, "toint");
+
+      if (typ->isFloatingPointTy())
+	 return build.GetBuilder().CreateUIToFP(val, typ, "tofp");
    }
 
-   //Return pointer to value, to be changed.
-   else return addr;
+   if (from->isIntegerTy() && typ->isFloatingPointTy())
+      return build.GetBuilder().CreateSIToFP(val, typ, "tofp");
+
+   if (from->isFloatingPointTy() && typ->isIntegerTy())
+      return build.GetBuilder().CreateFPToSI(val, typ, "toint");
+
+   return val;
 }
 
-llvm::Value* VarExpression::GenerateRHS(ParseScope& scope, ParseBuild& build, ParseInfo info)
+static llvm::AllocaInst*
+generate_var_address(ParseScope& scope, ParseInfo& info, symbol varName)
 {
    llvm::AllocaInst* addr = scope.is_in_scope(varName);
 
@@ -66,56 +89,53 @@ llvm::Value* VarExpression::GenerateRHS(ParseScope& scope, ParseBuild& build, Pa
    {
       Log::log_error(Error(0, 0,
 			   string("Variable name '" +
-				  varName +
+				  info.GetNames().name(varName).str() +
 				  "' not in scope.")));
-      return nullptr;
    }
 
-   else
-   {
-      //TODO: use the type-specific CreateLoad
-      return build.GetBuilder().CreateLoad(addr, varName);
-   }
+   return addr;
 }
 
-/*
-  NB: following two should not have a value to initialise to!! 
-  The init value is assigned with an enclosing Assign expression 
-  of some kind. These just allocate things to be assigned to.
-*/
-
-llvm::Value* InitVarExpression::Generate(ParseScope& scope, ParseBuild& build, ParseInfo info)
+static llvm::Value*
+generate_var_load(ParseScope& scope, ParseBuild& build, ParseInfo& info, symbol varName)
 {
-   //These are for inline declarations of variables.
+   llvm::AllocaInst* addr = generate_var_address(scope, info, varName);
+
+   if (!addr)
+      return nullptr;
 
+   return build.ReadVariable(addr, info.GetNames().name(varName));
+}
+
+static llvm::Value*
+generate_init_var(ParseScope& scope, ParseBuild& build, ParseInfo& info,
+		  symbol varName, symbol typName)
+{
    //Check not already in scope
    if (scope.is_in_scope(varName))
    {
       Log::log_error(Error(0, 0,
-			   string("Variable name '" + varName + "' is already used in the scope it is initialised in.")));
+			   string("Variable name '" + info.GetNames().name(varName).str() + "' is already used in the scope it is initialised in.")));
       return nullptr;
    }
 
    //This adds to scope, too.
-   llvm::AllocaInst* addr = build.allocate_instruction(scope,
+   llvm::AllocaInst* addr = build.declare_variable(scope,
 						       info.GetType(typName),
-						       varName);
+						       varName,
+						       info.GetNames().name(varName));
 
    //Return pointer, not value, because if anything it will be on the
    //left hand of an assign; a value will be dumped in the pointer.
    return addr;
 }
 
-llvm::Value* InitVarExpression::GenerateLHS(ParseScope& scope, ParseBuild& build, ParseInfo info)
-{
-   return Generate(scope, build, info);
-}
-
-llvm::Value* CallExpression::Generate(ParseScope& scope, ParseBuild& build, ParseInfo info)
+static llvm::Function*
+generate_callee(ParseBuild& build, symbol name, size_t nArgs)
 {
    //This is a global function table. Could add checks (possibly in
    //the llvm API?) for privacy etc.
-   llvm::Function* called = build.GetModule()->getFunction(name);
+   llvm::Function* called = build.GetCallee(name);
 
    if (!called)
    {
@@ -124,29 +144,20 @@ llvm::Value* CallExpression::Generate(ParseScope& scope, ParseBuild& build, Pars
       return nullptr;
    }
 
-   if (called->arg_size() != args.size())
+   if (called->arg_size() != nArgs)
    {
       Log::log_error(Error(0, 0,
 			   string("Not the right number of arguments in function call.")));
       return nullptr; //TODO format in # args
    }
 
-   vector<llvm::Value*> argValues;
-
-   for (unsigned int i = 0; i < args.size(); ++i)
-   {
-      argValues.push_back(args[i]->Generate(scope, build, info));
-
-      //Check each as you go along
-      if (!argValues.back())
-      {
-	 Log::log_error(Error(0, 0,
-			      string("Failure generating argument to function call."))); //TODO more informative
-	 
-	 return nullptr; //TODO log - but then, shouldn't the above Generate()?
-      }
-   }
+   return called;
+}
 
+static llvm::Value*
+generate_call(ParseBuild& build, ParseInfo& info, llvm::Function* called,
+	      llvm::ArrayRef<llvm::Value*> argValues, symbol name)
+{
    //Indices into struct returned by call
    vector<unsigned int> indices = {0};
 
@@ -154,16 +165,405 @@ llvm::Value* CallExpression::Generate(ParseScope& scope, ParseBuild& build, Pars
    //cases). This will need to be changed once tuples are properly
    //supported (because you should need to extract more than one
    //value); see comments in AssignExpression::Generate.
-   return build.GetBuilder().CreateExtractValue(build.GetBuilder().CreateCall(called, argValues, name),
+   llvm::StringRef calledName = info.GetNames().name(name);
+
+   llvm::SmallVector<llvm::Value*, 8> args;
+
+   for (size_t i = 0; i < argValues.size(); ++i)
+      args.push_back(generate_convert(build, argValues[i], called->getArg(i)->getType()));
+
+   return build.GetBuilder().CreateExtractValue(build.GetBuilder().CreateCall(called, args, calledName),
 						indices,
-						name + "_res");
+						calledName + "_res");
 }
 
-llvm::Value* BinaryExpression::Generate(ParseScope& scope, ParseBuild& build, ParseInfo info)
+/*
+  ^ and ¬/ on ints (i32, wrapping, as the other ops):
+
+  a ^ b is a multiplied by itself b times. For b < 0 it's what 1 / a^-b
+  would be truncated to: 1 for a = 1, +-1 for a = -1, otherwise 0
+  (0 ^ -b included, rather than dividing by 0).
+
+  n ¬/ x is the n-th root of x, rounded towards 0: for x < 0 and odd n,
+  minus the root of -x. Even roots of x < 0, and n < 1, are 0.
+
+  ParseFold works them out the same way (int_pow(), int_root()) when
+  both sides are literals.
+*/
+
+//A function of the module's own, made by 'body' the first time it's
+//wanted. Each module generated in parallel (see Generate(jobs)) makes
+//its own, so they're linkonce_odr, to be merged into one when those
+//are linked; and hidden, so an object doesn't export them
+static llvm::Function*
+get_helper(ParseBuild& build, llvm::StringRef name, unsigned nParams,
+	   function<void(llvm::Function*, llvm::IRBuilder<>&)> body)
 {
-   llvm::Value* left = lhs->Generate(scope, build, info);
-   llvm::Value* right = rhs->Generate(scope, build, info);
+   llvm::Module* mod = build.GetModule().get();
+
+   if (llvm::Function* func = mod->getFunction(name))
+      return func;
+
+   llvm::Type* i32 = llvm::Type::getInt32Ty(build.GetContext());
+
+   llvm::Function* func = llvm::Function::Create(llvm::FunctionType::get(i32,
+									 vector<llvm::Type*>(nParams, i32),
+									 false),
+						 llvm::Function::LinkOnceODRLinkage,
+						 name, mod);
+
+   func->setVisibility(llvm::GlobalValue::HiddenVisibility);
+
+   //Pure, so calls with the same args can be merged, hoisted or
+   //dropped
+   func->setDoesNotAccessMemory();
+   func->setDoesNotThrow();
+   func->setWillReturn();
+
+   //Its own builder, so the one generating the caller stays where it
+   //is
+   llvm::IRBuilder<> b(build.GetContext());
+
+   body(func, b);
+
+   return func;
+}
+
+//(For b < 0) what a ^ b comes to; see above
+static llvm::Value*
+generate_negative_pow(llvm::IRBuilder<>& b, llvm::Value* a, llvm::Value* odd)
+{
+   llvm::Value* minusOne = b.CreateSelect(odd, b.getInt32(-1), b.getInt32(1));
+
+   llvm::Value* res = b.CreateSelect(b.CreateICmpEQ(a, b.getInt32(-1)), minusOne, b.getInt32(0));
+
+   return b.CreateSelect(b.CreateICmpEQ(a, b.getInt32(1)), b.getInt32(1), res);
+}
+
+/*
+  adze.ipow(a, b): exponentiation by squaring, one multiply (or two)
+  per bit of b
+*/
+static llvm::Function*
+get_ipow(ParseBuild& build)
+{
+   return get_helper(build, "adze.ipow", 2, [&] (llvm::Function* func, llvm::IRBuilder<>& b)
+   {
+      llvm::LLVMContext& ctx = build.GetContext();
+      llvm::Value* a = func->getArg(0);
+      llvm::Value* e = func->getArg(1);
+
+      llvm::BasicBlock* entry = llvm::BasicBlock::Create(ctx, "entry", func);
+      llvm::BasicBlock* negative = llvm::BasicBlock::Create(ctx, "negative", func);
+      llvm::BasicBlock* loop = llvm::BasicBlock::Create(ctx, "loop", func);
+      llvm::BasicBlock* step = llvm::BasicBlock::Create(ctx, "step", func);
+      llvm::BasicBlock* done = llvm::BasicBlock::Create(ctx, "done", func);
+
+      b.SetInsertPoint(entry);
+      b.CreateCondBr(b.CreateICmpSLT(e, b.getInt32(0)), negative, loop);
+
+      b.SetInsertPoint(negative);
+      b.CreateRet(generate_negative_pow(b, a, b.CreateTrunc(e, b.getInt1Ty())));
+
+      //result *= base for each set bit of the exponent, squaring base
+      //each time
+      b.SetInsertPoint(loop);
+      llvm::PHINode* result = b.CreatePHI(b.getInt32Ty(), 2, "result");
+      llvm::PHINode* base = b.CreatePHI(b.getInt32Ty(), 2, "base");
+      llvm::PHINode* exp = b.CreatePHI(b.getInt32Ty(), 2, "exp");
+      b.CreateCondBr(b.CreateICmpEQ(exp, b.getInt32(0)), done, step);
+
+      b.SetInsertPoint(step);
+      llvm::Value* bit = b.CreateTrunc(exp, b.getInt1Ty());
+      llvm::Value* nextResult = b.CreateSelect(bit, b.CreateMul(result, base), result);
+      llvm::Value* nextBase = b.CreateMul(base, base);
+      llvm::Value* nextExp = b.CreateLShr(exp, 1);
+      b.CreateBr(loop);
+
+      result->addIncoming(b.getInt32(1), entry);
+      result->addIncoming(nextResult, step);
+      base->addIncoming(a, entry);
+      base->addIncoming(nextBase, step);
+      exp->addIncoming(e, entry);
+      exp->addIncoming(nextExp, step);
+
+      b.SetInsertPoint(done);
+      b.CreateRet(result);
+   });
+}
+
+/*
+  adze.iroot(n, x): binary search for the largest r with r^n <= |x|.
+  Worked in i64, so |INT_MIN| and the products checking each r fit;
+  no root of an i32 for n >= 2 is above 46340.
+*/
+static llvm::Function*
+get_iroot(ParseBuild& build)
+{
+   return get_helper(build, "adze.iroot", 2, [&] (llvm::Function* func, llvm::IRBuilder<>& b)
+   {
+      llvm::LLVMContext& ctx = build.GetContext();
+      llvm::Value* n = func->getArg(0);
+      llvm::Value* x = func->getArg(1);
+
+      llvm::BasicBlock* entry = llvm::BasicBlock::Create(ctx, "entry", func);
+      llvm::BasicBlock* search = llvm::BasicBlock::Create(ctx, "search", func);
+      llvm::BasicBlock* probe = llvm::BasicBlock::Create(ctx, "probe", func);
+      llvm::BasicBlock* power = llvm::BasicBlock::Create(ctx, "power", func);
+      llvm::BasicBlock* multiply = llvm::BasicBlock::Create(ctx, "multiply", func);
+      llvm::BasicBlock* narrow = llvm::BasicBlock::Create(ctx, "narrow", func);
+      llvm::BasicBlock* done = llvm::BasicBlock::Create(ctx, "done", func);
+
+      llvm::Type* i64 = b.getInt64Ty();
+
+      b.SetInsertPoint(entry);
+      llvm::Value* neg = b.CreateICmpSLT(x, b.getInt32(0));
+      llvm::Value* wide = b.CreateSExt(x, i64);
+      llvm::Value* mag = b.CreateSelect(neg, b.CreateNeg(wide), wide, "mag");
+      llvm::Value* limit = b.CreateSelect(b.CreateICmpSLT(mag, b.getInt64(46340)),
+					  mag, b.getInt64(46340));
+      llvm::Value* hiStart = b.CreateAdd(limit, b.getInt64(1));
+      llvm::Value* wideN = b.CreateSExt(n, i64);
+      b.CreateBr(search);
+
+      //Invariant: lo^n <= mag < hi^n
+      b.SetInsertPoint(search);
+      llvm::PHINode* lo = b.CreatePHI(i64, 2, "lo");
+      llvm::PHINode* hi = b.CreatePHI(i64, 2, "hi");
+      b.CreateCondBr(b.CreateICmpSGT(b.CreateSub(hi, lo), b.getInt64(1)), probe, done);
+
+      b.SetInsertPoint(probe);
+      llvm::Value* mid = b.CreateLShr(b.CreateAdd(lo, hi), 1, "mid");
+      b.CreateBr(power);
+
+      //mid^n, stopping as soon as it's past mag (within 32 multiplies
+      //for mid >= 2; mid = 1 stays 1, so stops at once)
+      b.SetInsertPoint(power);
+      llvm::PHINode* p = b.CreatePHI(i64, 2, "p");
+      llvm::PHINode* i = b.CreatePHI(i64, 2, "i");
+      llvm::Value* over = b.CreateICmpSGT(p, mag);
+      llvm::Value* more = b.CreateAnd(b.CreateICmpSLT(i, wideN),
+				      b.CreateICmpSGT(mid, b.getInt64(1)));
+      b.CreateCondBr(b.CreateAnd(more, b.CreateNot(over)), multiply, narrow);
+
+      b.SetInsertPoint(multiply);
+      llvm::Value* nextP = b.CreateMul(p, mid);
+      llvm::Value* nextI = b.CreateAdd(i, b.getInt64(1));
+      b.CreateBr(power);
+
+      p->addIncoming(b.getInt64(1), probe);
+      p->addIncoming(nextP, multiply);
+      i->addIncoming(b.getInt64(0), probe);
+      i->addIncoming(nextI, multiply);
+
+      b.SetInsertPoint(narrow);
+      llvm::Value* fits = b.CreateNot(over);
+      llvm::Value* nextLo = b.CreateSelect(fits, mid, lo);
+      llvm::Value* nextHi = b.CreateSelect(fits, hi, mid);
+      b.CreateBr(search);
+
+      lo->addIncoming(b.getInt64(0), entry);
+      lo->addIncoming(nextLo, narrow);
+      hi->addIncoming(hiStart, entry);
+      hi->addIncoming(nextHi, narrow);
+
+      //The special cases, picked out at the end rather than branched
+      //to; the search above is bounded whatever n and x are
+      b.SetInsertPoint(done);
+      llvm::Value* root = b.CreateTrunc(lo, b.getInt32Ty());
+      llvm::Value* even = b.CreateNot(b.CreateTrunc(n, b.getInt1Ty()));
+      llvm::Value* res = b.CreateSelect(neg, b.CreateNeg(root), root);
+      res = b.CreateSelect(b.CreateAnd(neg, even), b.getInt32(0), res);
+      res = b.CreateSelect(b.CreateICmpEQ(n, b.getInt32(1)), x, res);
+      res = b.CreateSelect(b.CreateICmpSLT(n, b.getInt32(1)), b.getInt32(0), res);
+      b.CreateRet(res);
+   });
+}
+
+//base ^ k for a k known now: an unrolled chain of squares and
+//multiplies, left to right through k's bits
+static llvm::Value*
+generate_pow_chain(ParseBuild& build, llvm::Value* base, int64_t k)
+{
+   llvm::IRBuilder<>& b = build.GetBuilder();
+   bool isFloat = base->getType()->isFloatingPointTy();
+
+   if ((k < 0) && !isFloat)
+      return generate_negative_pow(b, base, b.getInt1(k & 1));
+
+   uint64_t mag = (k < 0) ? -(uint64_t) k : (uint64_t) k;
+   llvm::Value* result = nullptr;
+
+   for (int bit = 63; bit >= 0; --bit)
+   {
+      if (result)
+	 result = isFloat ? b.CreateFMul(result, result, "sq") : b.CreateMul(result, result, "sq");
+
+      if ((mag >> bit) & 1)
+      {
+	 if (!result)
+	    result = base;
+
+	 else result = isFloat ? b.CreateFMul(result, base, "pow") : b.CreateMul(result, base, "pow");
+      }
+   }
+
+   if (!result)
+      result = isFloat ? llvm::ConstantFP::get(base->getType(), 1.0) : b.getInt32(1);
+
+   if (k < 0)
+      result = b.CreateFDiv(llvm::ConstantFP::get(base->getType(), 1.0), result, "inv");
+
+   return result;
+}
+
+static llvm::Value*
+generate_exp(ParseBuild& build, llvm::Value* base, llvm::Value* exp)
+{
+   llvm::IRBuilder<>& b = build.GetBuilder();
+
+   //A real exponent: llvm.pow, in floats
+   if (exp->getType()->isFloatingPointTy())
+   {
+      if (!base->getType()->isFloatingPointTy())
+	 base = b.CreateSIToFP(base, exp->getType());
+
+      return b.CreateBinaryIntrinsic(llvm::Intrinsic::pow, base, exp, nullptr, "pow");
+   }
+
+   if (llvm::ConstantInt* k = llvm::dyn_cast<llvm::ConstantInt>(exp))
+      return generate_pow_chain(build, base, k->getSExtValue());
+
+   if (base->getType()->isFloatingPointTy())
+      return b.CreateIntrinsic(llvm::Intrinsic::powi, {base->getType(), exp->getType()},
+			       {base, exp}, nullptr, "powi");
+
+   return b.CreateCall(get_ipow(build), {base, exp}, "pow");
+}
+
+static llvm::Value*
+generate_root(ParseBuild& build, llvm::Value* index, llvm::Value* x)
+{
+   llvm::IRBuilder<>& b = build.GetBuilder();
+
+   llvm::ConstantInt* intIndex = llvm::dyn_cast<llvm::ConstantInt>(index);
+   llvm::ConstantFP* fpIndex = llvm::dyn_cast<llvm::ConstantFP>(index);
+   bool square = (intIndex && intIndex->equalsInt(2)) ||
+      (fpIndex && fpIndex->isExactlyValue(2.0));
+
+   //Anything real: llvm.sqrt, or llvm.pow(x, 1 / index)
+   if (x->getType()->isFloatingPointTy() || index->getType()->isFloatingPointTy())
+   {
+      llvm::Type* fp = x->getType()->isFloatingPointTy() ? x->getType() : index->getType();
+
+      if (!x->getType()->isFloatingPointTy())
+	 x = b.CreateSIToFP(x, fp);
+
+      if (square)
+	 return b.CreateUnaryIntrinsic(llvm::Intrinsic::sqrt, x, nullptr, "sqrt");
+
+      if (!index->getType()->isFloatingPointTy())
+	 index = b.CreateSIToFP(index, fp);
+
+      else if (index->getType() != fp)
+	 index = b.CreateFPCast(index, fp);
+
+      llvm::Value* recip = b.CreateFDiv(llvm::ConstantFP::get(fp, 1.0), index, "recip");
+
+      return b.CreateBinaryIntrinsic(llvm::Intrinsic::pow, x, recip, nullptr, "root");
+   }
+
+   //An int square root, as a double's: exact for every i32, as no
+   //root is within a rounding of the next int up
+   if (square)
+   {
+      //Exactly, even with fast-math on
+      llvm::IRBuilder<>::FastMathFlagGuard exact(b);
+
+      b.clearFastMathFlags();
+
+      llvm::Value* sqrt = b.CreateUnaryIntrinsic(llvm::Intrinsic::sqrt,
+						 b.CreateSIToFP(x, b.getDoubleTy()),
+						 nullptr, "sqrt");
+      llvm::Value* root = b.CreateFPToSI(sqrt, b.getInt32Ty());
+
+      //(sqrt of a negative is NaN, which converts to poison, so it's
+      //replaced rather than used)
+      return b.CreateSelect(b.CreateICmpSLT(x, b.getInt32(0)), b.getInt32(0), root, "root");
+   }
+
+   if (intIndex && intIndex->equalsInt(1))
+      return x;
+
+   return b.CreateCall(get_iroot(build), {index, x}, "root");
+}
+
+/*
+  The ops of generate_binary() where either side is a float: the other
+  is made one too if it's an int, as C would. (^ and ¬/ see to their
+  own mixes; see generate_exp() and generate_root().) With fast-math
+  on, the builder's flags go on each.
+*/
+static llvm::Value*
+generate_float_binary(ParseBuild& build, token_kind op, llvm::Value* left, llvm::Value* right)
+{
+   llvm::IRBuilder<>& b = build.GetBuilder();
+
+   llvm::Type* fp = left->getType()->isFloatingPointTy() ? left->getType() : right->getType();
+
+   left = generate_convert(build, left, fp);
+   right = generate_convert(build, right, fp);
+
+   switch (op)
+   {
+      case token_kind::OP_ADD:
+	 return b.CreateFAdd(left, right, "add");
+
+      case token_kind::OP_SUB:
+	 return b.CreateFSub(left, right, "sub");
+
+      case token_kind::OP_MUL:
+	 return b.CreateFMul(left, right, "mul");
+
+      case token_kind::OP_DIV:
+	 return b.CreateFDiv(left, right, "div");
+
+      case token_kind::OP_MOD:
+	 //As C's fmod(): the sign of the left
+	 return b.CreateFRem(left, right, "mod");
+
+      //Ordered, as C's are: false with a NaN on either side (but for
+      //!=)
+      case token_kind::OP_LT:
+	 return b.CreateFCmpOLT(left, right, "lt");
+
+      case token_kind::OP_GT:
+	 return b.CreateFCmpOGT(left, right, "gt");
+
+      case token_kind::OP_LE:
+	 return b.CreateFCmpOLE(left, right, "le");
+
+      case token_kind::OP_GE:
+	 return b.CreateFCmpOGE(left, right, "ge");
+
+      case token_kind::OP_EQ:
+	 return b.CreateFCmpOEQ(left, right, "eq");
+
+      case token_kind::OP_NE:
+	 return b.CreateFCmpUNE(left, right, "ne");
+
+      default:
+      {
+	 Log::log_error(Error(0, 0,
+			      string("A binary expression was parsed that wasn't recognised...")));
+	 return nullptr;
+      }
+   }
+}
 
+static llvm::Value*
+generate_binary(ParseBuild& build, token_kind op, llvm::Value* left, llvm::Value* right)
+{
    if (!left)
    {
       if (!right)
@@ -194,6 +594,17 @@ llvm::Value* BinaryExpression::Generate(ParseScope& scope, ParseBuild& build, Pa
      undefined behaviour, e.g. division by 0.
     */
 
+   //Comparisons make bools, which are ints 0 or 1 as operands
+   if (left->getType()->isIntegerTy(1))
+      left = generate_convert(build, left, build.GetBuilder().getInt32Ty());
+
+   if (right->getType()->isIntegerTy(1))
+      right = generate_convert(build, right, build.GetBuilder().getInt32Ty());
+
+   if (((op != token_kind::OP_EXP) && (op != token_kind::OP_ROOT)) &&
+       (left->getType()->isFloatingPointTy() || right->getType()->isFloatingPointTy()))
+      return generate_float_binary(build, op, left, right);
+
    switch(op)
    {
       case token_kind::OP_ADD:
@@ -212,10 +623,34 @@ llvm::Value* BinaryExpression::Generate(ParseScope& scope, ParseBuild& build, Pa
 	 //NB that 'signed remainder' is not the same as modulo.
 	 return build.GetBuilder().CreateURem(left, right, "mod");
 
+      case token_kind::OP_SHL:
+	 return build.GetBuilder().CreateShl(left, right, "shl");
+
+      case token_kind::OP_LT:
+	 return build.GetBuilder().CreateICmpSLT(left, right, "lt");
+
+      case token_kind::OP_GT:
+	 return build.GetBuilder().CreateICmpSGT(left, right, "gt");
+
+      case token_kind::OP_LE:
+	 return build.GetBuilder().CreateICmpSLE(left, right, "le");
+
+      case token_kind::OP_GE:
+	 return build.GetBuilder().CreateICmpSGE(left, right, "ge");
+
+      case token_kind::OP_EQ:
+	 return build.GetBuilder().CreateICmpEQ(left, right, "eq");
+
+      case token_kind::OP_NE:
+	 return build.GetBuilder().CreateICmpNE(left, right, "ne");
+
       case token_kind::OP_EXP:
-	 //TODO: for loop
+	 return generate_exp(build, left, right);
+
       case token_kind::OP_ROOT:
-	 //TODO: ditto
+	 //The index comes first, as in the written form
+	 return generate_root(build, left, right);
+
       default:
       {
 	 Log::log_error(Error(0, 0,
@@ -228,104 +663,274 @@ llvm::Value* BinaryExpression::Generate(ParseScope& scope, ParseBuild& build, Pa
    //TODO Could handle overloads, etc.
 }
 
-llvm::Value* FunctionExpression::Generate(ParseScope& scope, ParseBuild& build, ParseInfo info)
+//val as a bool, to branch on: a comparison's, or whether it isn't 0
+static llvm::Value*
+generate_condition(ParseBuild& build, llvm::Value* val)
 {
-   //Only generate the signature if it hasn't already been done.
-   llvm::Function* func = (llvm::Function*) build.GetModule()->getFunction(signature->GetFuncName());
-
-   if (!func)
+   if (!val)
    {
-      func = (llvm::Function*) signature->Generate(scope, build, info);
+      Log::log_error(Error(0, 0,
+			   string("Failure generating a condition.")));
+      return nullptr;
+   }
 
-      if (!func)
+   if (val->getType()->isIntegerTy(1))
+      return val;
+
+   if (val->getType()->isFloatingPointTy())
+      return build.GetBuilder().CreateFCmpUNE(val, llvm::ConstantFP::get(val->getType(), 0.0), "cond");
+
+   return build.GetBuilder().CreateICmpNE(val, llvm::ConstantInt::get(val->getType(), 0), "cond");
+}
+
+static llvm::Value*
+generate_assign(ParseBuild& build, llvm::Value* l, llvm::Value* r)
+{
+   if (!r)
+   {
+      if (!l)
       {
 	 Log::log_error(Error(0, 0,
-			      string("Failure generating function signature.")));
+			      string("Failure generating either side of assignment.")));
 	 return nullptr;
       }
-   }
 
-   else
-   {
-      //If the signature has already been generated, better make sure
-      //the body hasn't been too!
-      if (func->isDeclaration())
+      else
       {
 	 Log::log_error(Error(0, 0,
-			      string("A function was wrongly redeclared.")));
-	 //TODO more informative - get line from func.
-	 //(How would llvm know...?)
+			      string("Failure generating right-hand side of assignment.")));
 	 return nullptr;
       }
    }
 
-   build.BuildFunction(scope, func);
-
-   //Special handling for declaration of params from signature.
-   //(Declarations of temporaries in body are done on the fly.)
+   else if (!l)
+   {
+      Log::log_error(Error(0, 0,
+			   string("Failure generating left-hand side of assignment.")));
+      return nullptr;
+   }
+   
+   //Only variables have l-values
+   llvm::AllocaInst* var = llvm::cast<llvm::AllocaInst>(l);
 
-   //This should be different depending on whether it's a value or a ref...
+   return build.WriteVariable(var, generate_convert(build, r, var->getAllocatedType()));
+}
 
-   int i = 0;
-   
-   for (llvm::Function::arg_iterator it = func->arg_begin();
-	it != func->arg_end();
-	++it, ++i)
+static llvm::Value*
+generate_return(ParseBuild& build, llvm::ArrayRef<llvm::Value*> vals)
+{
+   if (vals.size())
    {
-      /*
-	NB following is odd because allocas implies they're going
-	to be -stored- to. But params shouldn't really be mutable
+      //Each as the function returns it
+      llvm::Type* rets = build.GetBuilder().GetInsertBlock()->getParent()->getReturnType();
+      llvm::SmallVector<llvm::Value*, 4> converted;
 
-	Rather than manage a further scope map (names -> Value*s),
-	though, I will do it as if they were allocas. Mutability
-	can just be a separate constraint. The use of allocas,
-	if it's worse, will presumably be optimised by LLVM, or it
-	might be better anyway (if use of a Value implies
-	pass-by-copy).
+      for (size_t i = 0; i < vals.size(); ++i)
+      {
+	 llvm::Type* typ = (rets->isStructTy() && (i < rets->getStructNumElements())) ?
+	    rets->getStructElementType(i) : vals[i]->getType();
 
-	(I believe LLVM advises you do this anyway (even if they
-	shouldn't be mutable), for ease of optimisation.)
-      */
+	 converted.push_back(generate_convert(build, vals[i], typ));
+      }
 
-      token_kind paramType = signature->GetParamType(i);
+      return build.GetBuilder().CreateAggregateRet(converted.data(), converted.size());
+   }
 
-      //(This adds to scope too)
-      llvm::AllocaInst* alloc = build.allocate_instruction(scope,
-							   info.GetType(paramType),
-							   signature->GetParamName(i));
+   else return build.GetBuilder().CreateRetVoid();
+}
 
-      //Store to that variable
-      //Tbh might want to just replace this with a const variable
-      //stack,
-      //since it's not obvious how extra instructions are helping here.
-      build.GetBuilder().CreateStore(&(*it), alloc);
+static llvm::Function*
+generate_signature(ParseBuild& build, ParseInfo& info, symbol funcName,
+		   llvm::ArrayRef<symbol> rets,
+		   llvm::ArrayRef<tuple<symbol, symbol>> params)
+{
+   vector<llvm::Type*> parArgs;
+   
+   for (unsigned int i = 0; i < params.size(); ++i)
+   {
+      llvm::Type* typePtr = info.GetType(get<0>(params[i]));
+
+      if (!typePtr)
+	 break;
+
+      else parArgs.push_back(typePtr);
+	 
+       /*
+	 default:
+	    //If not primitive type, find it in parser names
+	 {
+	    if (prs.names.count(typ.GetValue()))
+	    {
+	       //TODO
+	    }
+
+	    else
+	    {
+	       //TODO log
+	       return nullptr;
+	    }
+	 }
+       */
    }
 
-   //Actual generation of the statements
-   //Naive implementation: just 1:1 replicate calls.
-   //You're leaving optimisations up to llvm in that case.
+   llvm::FunctionType* funcType = nullptr;
 
-   for (unsigned int i = 0; i < statements.size(); ++i)
+   //Compose struct type for multiple returns
+   if (rets.size())
    {
-      //These Generate()s should handle scope on their own - e.g., if
-      //an expression involves a block, it will make its own IR block.
-      //NB they should go back to previous block, too.
-      //(or, make a temporary Builder with its own insert-point- but
-      //then they'd have to pass them on and back)
+      vector<llvm::Type*> returnTypes;
 
-      statements[i]->Generate(scope, build, info);
+      returnTypes.resize(rets.size());
+
+      for (unsigned int i = 0; i < rets.size(); ++i)
+      {
+	 token_kind retKind = Interner::builtin_kind(rets[i]);
+
+	 if (retKind == token_kind::TYPE_INT)
+	 { returnTypes[i] = llvm::Type::getInt32Ty(build.GetContext()); }
+      
+	 else if (retKind == token_kind::TYPE_FLOAT)
+	 { returnTypes[i] = llvm::Type::getFloatTy(build.GetContext()); }
+
+	 //TODO string
+      }
+
+      funcType = llvm::FunctionType::get(llvm::StructType::get(build.GetContext(),
+							       returnTypes,
+							       false), //whether packed or not
+					 parArgs,
+					 false);
    }
 
+   else
+   {
+      funcType = llvm::FunctionType::get(llvm::Type::getVoidTy(build.GetContext()),
+					 parArgs,
+					 false);
+   }
+
+   llvm::Function* func = llvm::Function::Create(funcType,
+						 llvm::Function::ExternalLinkage,
+						 info.GetNames().name(funcName),
+						 build.GetModule().get());
+
+   build.AddFunction(funcName, func);
+
+   //Set name of params
+   unsigned int i = 0;
+   
+   for (auto &it : func->args())
+   {
+      it.setName(info.GetNames().name(get<1>(params[i])));
+
+      ++i;
+   }
+
+   return func;
+}
+
+//Up to the function's statements: declare it if need be, start its
+//entry block and set up its params
+static llvm::Function*
+generate_function_entry(ParseScope& scope, ParseBuild& build, ParseInfo& info,
+			symbol funcName,
+			llvm::ArrayRef<symbol> rets,
+			llvm::ArrayRef<tuple<symbol, symbol>> params)
+{
+   //Only generate the signature if it hasn't already been done.
+   llvm::Function* func = build.GetFunction(funcName);
+
+   if (!func)
+   {
+      func = generate_signature(build, info, funcName, rets, params);
+
+      if (!func)
+      {
+	 Log::log_error(Error(0, 0,
+			      string("Failure generating function signature.")));
+	 return nullptr;
+      }
+   }
+
+   else
+   {
+      //If the signature has already been generated, better make sure
+      //the body hasn't been too!
+      if (func->isDeclaration())
+      {
+	 Log::log_error(Error(0, 0,
+			      string("A function was wrongly redeclared.")));
+	 //TODO more informative - get line from func.
+	 //(How would llvm know...?)
+	 return nullptr;
+      }
+   }
+
+   build.BuildFunction(scope, func);
+
+   //Special handling for declaration of params from signature.
+   //(Declarations of temporaries in body are done on the fly.)
+
+   //This should be different depending on whether it's a value or a ref...
+
+   int i = 0;
+   
+   for (llvm::Function::arg_iterator it = func->arg_begin();
+	it != func->arg_end();
+	++it, ++i)
+   {
+      /*
+	NB following is odd because allocas implies they're going
+	to be -stored- to. But params shouldn't really be mutable
+
+	Rather than manage a further scope map (names -> Value*s),
+	though, I will do it as if they were allocas. Mutability
+	can just be a separate constraint. The use of allocas,
+	if it's worse, will presumably be optimised by LLVM, or it
+	might be better anyway (if use of a Value implies
+	pass-by-copy).
+
+	(I believe LLVM advises you do this anyway (even if they
+	shouldn't be mutable), for ease of optimisation.)
+      */
+
+      symbol paramName = get<1>(params[i]);
+
+      //(This adds to scope too)
+      llvm::AllocaInst* alloc = build.declare_variable(scope,
+							   info.GetType(get<0>(params[i])),
+							   paramName,
+							   info.GetNames().name(paramName));
+
+      //Store to that variable
+      //Tbh might want to just replace this with a const variable
+      //stack,
+      //since it's not obvious how extra instructions are helping here.
+      //(With SSA on, that's what happens: the param is just the
+      //variable's value)
+      build.WriteVariable(alloc, &(*it));
+   }
+
+   return func;
+}
+
+//After the function's statements
+static llvm::Value*
+generate_function_exit(ParseScope& scope, ParseBuild& build, ParseInfo& info,
+		       llvm::Function* func, symbol funcName, bool isVoid)
+{
    //Should now be back in entry block.
 
    //Pop scoped names
    scope.pop_scope();
 
+   build.FinishFunction();
+
    //Might already be a return (in this block).
    //TODO: since stmts are meant to be expressions, they should all be
    //at this scope (only subordinate expressions won't be). So you
    //should be able to just check the last one is a return.
-   if (signature->IsVoid())
+   if (isVoid)
    {
       build.GetBuilder().CreateRetVoid();
    }
@@ -335,14 +940,14 @@ llvm::Value* FunctionExpression::Generate(ParseScope& scope, ParseBuild& build,
 
    //TODO This has an output stream if you want a debug message
    //NB the weird T/F conditions here
-   if (llvm::verifyFunction(*func, &llvm::errs()))
+   if (llvm::verifyFunction(*func, &build.GetDiagnostics()))
    {
       //func->eraseFromParent(); //TODO reinstate this (though good for debug)
 
       //TODO: make more informative? Ideally it'd work out -why-
       Log::log_error(Error(0, 0,
 			   string("Function '" +
-				  signature->GetFuncName()  +
+				  info.GetNames().name(funcName).str()  +
 				  "' failed to be verified.")));
       return nullptr;
    }
@@ -350,129 +955,439 @@ llvm::Value* FunctionExpression::Generate(ParseScope& scope, ParseBuild& build,
    else return func;
 }
 
-llvm::Value* ReturnExpression::Generate(ParseScope& scope, ParseBuild& build, ParseInfo info)
+/*
+  A loop, generating its parts through the functions given (init and
+  step returning false if they fail; a while just succeeds), as a
+  canonical loop, as LLVM's loop passes want one:
+
+  (here)  init; br loop            <- the preheader
+  loop:   br cond, body, exit      <- the header
+  body:   ...; br latch
+  latch:  step; br loop            <- the one latch, and back edge
+  exit:   (go on from here)
+
+  The header's preds aren't all known until the latch is done, so
+  it's sealed last; with SSA on, a variable the loop changes (like
+  its counter) is a phi there. The latch's branch gets the loop's
+  metadata (see ParseBuild::MakeLoopID()).
+*/
+static llvm::Value*
+generate_loop(ParseScope& scope, ParseBuild& build,
+	      function<bool()> init, function<llvm::Value*()> cond,
+	      function<bool()> step, function<void()> body)
 {
-   //Check # of args and types, too
-   //But this can only be done in the context of a function...
-   //So I'll do it in FunctionExpression...?
-   
-   //Or you could do it like the scope 'stack', and keep a
-   //record of current function's expected returns
+   llvm::IRBuilder<>& b = build.GetBuilder();
 
-   if (rets.size())
+   //The init's names only last as long as the loop
+   scope.push_scope();
+
+   if (!init())
    {
-      llvm::Value* vals[rets.size()];
+      Log::log_error(Error(0, 0,
+			   string("Failure generating the start of a loop.")));
+      scope.pop_scope();
+      return nullptr;
+   }
 
-      for (unsigned int i = 0; i < rets.size(); ++i)
-      {
-	 vals[i] = rets[i]->Generate(scope, build, info);
+   llvm::BasicBlock* header = build.NewBlock("loop");
+   llvm::BasicBlock* bodyBlock = build.NewBlock("body");
+   llvm::BasicBlock* latch = build.NewBlock("latch");
+   llvm::BasicBlock* exit = build.NewBlock("exit");
 
-	 if (!vals[i])
-	 {
-	    //TODO: more informative?
-	    Log::log_error(Error(0, 0,
-				 string("Failed to generate expression being returned.")));
-	    return nullptr;
-	 }
-      }
+   b.CreateBr(header);
 
-      return build.GetBuilder().CreateAggregateRet(vals, rets.size());
+   build.SetBlock(header);
+
+   llvm::Value* c = generate_condition(build, cond());
+
+   if (!c)
+   {
+      scope.pop_scope();
+      return nullptr;
    }
 
-   else
+   b.CreateCondBr(c, bodyBlock, exit);
+
+   build.SealBlock(bodyBlock);
+   build.SetBlock(bodyBlock);
+
+   //And the body's only last each time round
+   scope.push_scope();
+
+   body();
+
+   scope.pop_scope();
+
+   //(Unless the body returned)
+   if (!b.GetInsertBlock()->getTerminator())
+      b.CreateBr(latch);
+
+   build.SealBlock(latch);
+   build.SetBlock(latch);
+
+   if (!step())
+      Log::log_error(Error(0, 0,
+			   string("Failure generating the step of a loop.")));
+
+   llvm::BranchInst* back = b.CreateBr(header);
+
+   if (llvm::MDNode* id = build.MakeLoopID())
+      back->setMetadata(llvm::LLVMContext::MD_loop, id);
+
+   build.SealBlock(header);
+   build.SealBlock(exit);
+   build.SetBlock(exit);
+
+   scope.pop_scope();
+
+   return back;
+}
+
+void Parser::Generate()
+{
+   //From the flat tree, if Flatten() made one
+   if (!flat.empty())
+   {
+      flat.Generate(scope, build, info, generated);
+
+      return;
+   }
+
+   for (unsigned int i = 0; i < parsed.size(); ++i)
    {
-      return build.GetBuilder().CreateRetVoid();
+      generated.push_back(parsed[i]->Generate(scope, build, info));
    }
 }
 
-llvm::Function* SignatureExpression::Generate(ParseScope& scope, ParseBuild& build, ParseInfo info)
+void Parser::Generate(unsigned jobs, int level)
 {
-   vector<llvm::Type*> parArgs;
-   
-   for (unsigned int i = 0; i < params.size(); ++i)
+   size_t nShards = std::min<size_t>(jobs, parsed.size());
+
+   //Passing the shards back and linking them costs more than just
+   //generating does, so it's only worth it if there's optimising to be
+   //done in them as well
+   if ((nShards < 2) || (level < 1))
    {
-      const token& typ = GetParamType(i);
+      Generate();
 
-      llvm::Type* typePtr = info.GetType(typ.GetKind());
+      if (level >= 0)
+	 build.Optimise(level);
 
-      if (!typePtr)
-	 break;
+      return;
+   }
 
-      else parArgs.push_back(typePtr);
-	 
-       /*
-	 default:
-	    //If not primitive type, find it in parser names
-	 {
-	    if (prs.names.count(typ.GetValue()))
-	    {
-	       //TODO
-	    }
+   /*
+     Each shard is a run of functions, in source order, generated on
+     a thread of its own with its own ParseBuild (so its own context
+     and module) and scope, targeted as build is, and optimised there
+     too. What comes before it is declared from its
+     SignatureExpressions first, so calls resolve just as they would
+     generating in one go. Each module is then passed back to this
+     context as bitcode (an llvm::Module can't move between contexts)
+     and linked into one; the helpers each one has made (get_helper())
+     are merged then.
+   */
+   struct shard
+   {
+      size_t first;
+      size_t last;
+      vector<Error> errors; //Logged while generating it
+      llvm::SmallVector<char, 0> bitcode;
+   };
 
-	    else
-	    {
-	       //TODO log
-	       return nullptr;
-	    }
-	 }
-       */
+   vector<shard> shards(nShards);
+
+   for (size_t s = 0; s < nShards; ++s)
+   {
+      shards[s].first = parsed.size() * s / nShards;
+      shards[s].last = parsed.size() * (s + 1) / nShards;
    }
 
-   llvm::FunctionType* funcType = nullptr;
+   auto work = [&] (shard& sh)
+   {
+      ParseBuild shBuild;
+      ParseScope shScope;
+      ParseInfo shInfo(shBuild, names, arena); //(arena goes unused)
 
-   //Compose struct type for multiple returns
-   if (rets.size())
+      shBuild.SetSSA(ssa);
+      shBuild.SetFastMath(fastMath);
+      shBuild.SetLoopHints(vectorizeWidth, unrollCount);
+
+      vector<llvm::Value*> shGenerated;
+
+      //If anything goes wrong it's all done again in one go, so
+      //nothing from here needs to be seen
+      shBuild.SetDiagnostics(llvm::nulls());
+
+      Log::begin_capture(sh.errors);
+
+      shBuild.SetTargetAs(build);
+
+      for (size_t i = 0; i < sh.first; ++i)
+      {
+	 Expression* sig = static_cast<FunctionExpression*>(parsed[i])->GetSignature();
+
+	 if (!shBuild.GetFunction(sig->GetFuncName()))
+	    sig->Generate(shScope, shBuild, shInfo);
+      }
+
+      if (!flat.empty())
+	 flat.Generate(shScope, shBuild, shInfo, shGenerated, sh.first, sh.last);
+
+      else for (size_t i = sh.first; i < sh.last; ++i)
+      {
+	 shGenerated.push_back(parsed[i]->Generate(shScope, shBuild, shInfo));
+      }
+
+      Log::end_capture();
+
+      if (sh.errors.empty())
+      {
+	 if (level >= 0)
+	    shBuild.Optimise(level);
+
+	 llvm::raw_svector_ostream stream(sh.bitcode);
+
+	 llvm::WriteBitcodeToFile(*shBuild.GetModule(), stream);
+      }
+   };
+
+   vector<thread> threads;
+
+   for (size_t s = 1; s < nShards; ++s)
+      threads.emplace_back(work, ref(shards[s]));
+
+   work(shards[0]);
+
+   for (thread& t : threads)
+      t.join();
+
+   unique_ptr<llvm::Module> linked = std::make_unique<llvm::Module>("adze", build.GetContext());
+
+   linked->setTargetTriple(build.GetModule()->getTargetTriple());
+   linked->setDataLayout(build.GetModule()->getDataLayout());
+
+   bool ok = true;
+
+   for (shard& sh : shards)
    {
-      vector<llvm::Type*> returnTypes;
+      if (!sh.errors.empty())
+      {
+	 ok = false;
 
-      returnTypes.resize(rets.size());
+	 break;
+      }
 
-      for (unsigned int i = 0; i < rets.size(); ++i)
+      llvm::StringRef bitcode(sh.bitcode.data(), sh.bitcode.size());
+
+      llvm::Expected<unique_ptr<llvm::Module>> mod =
+	 llvm::parseBitcodeFile(llvm::MemoryBufferRef(bitcode, "shard"), build.GetContext());
+
+      if (!mod)
       {
-	 if (rets[i] == "int")
-	 { returnTypes[i] = llvm::Type::getInt32Ty(build.GetContext()); }
-      
-	 else if (rets[i] == "float")
-	 { returnTypes[i] = llvm::Type::getFloatTy(build.GetContext()); }
+	 llvm::consumeError(mod.takeError());
+	 ok = false;
 
-	 //TODO string
+	 break;
       }
 
-      funcType = llvm::FunctionType::get(llvm::StructType::get(build.GetContext(),
-							       returnTypes,
-							       false), //whether packed or not
-					 parArgs,
-					 false);
+      //(true on failure)
+      if (llvm::Linker::linkModules(*linked, move(*mod)))
+      {
+	 ok = false;
+
+	 break;
+      }
    }
 
-   else
+   //Errors (and what IR there is) come out in order from generating
+   //in one go, so that's what's done
+   if (!ok)
    {
-      funcType = llvm::FunctionType::get(llvm::Type::getVoidTy(build.GetContext()),
-					 parArgs,
-					 false);
+      Generate();
+
+      if (level >= 0)
+	 build.Optimise(level);
+
+      return;
    }
 
-   llvm::Function* func = llvm::Function::Create(funcType,
-						 llvm::Function::ExternalLinkage,
-						 funcName,
-						 build.GetModule().get());
+   build.GetModule() = move(linked);
 
-   //Set name of params
-   unsigned int i = 0;
+   for (Expression* expr : parsed)
+   {
+      symbol name = static_cast<FunctionExpression*>(expr)->GetSignature()->GetFuncName();
+      llvm::Function* func = build.GetModule()->getFunction(names.name(name));
+
+      build.AddFunction(name, func);
+      generated.push_back(func);
+   }
+}
+
+llvm::Value* LitIntExpression::Generate(ParseScope& scope, ParseBuild& build, ParseInfo& info)
+{
+   return generate_lit_int(build, value);
+}
+
+llvm::Value* LitFloatExpression::Generate(ParseScope& scope, ParseBuild& build, ParseInfo& info)
+{
+   return generate_lit_float(build, value);
+}
+
+llvm::Value* VarExpression::Generate(ParseScope& scope, ParseBuild& build, ParseInfo& info)
+{
+   //By default return value, not pointer; exceptions won't call
+   //Generate, but GenerateLHS.
+   return GenerateRHS(scope, build, info);
+}
+
+llvm::Value* VarExpression::GenerateLHS(ParseScope& scope, ParseBuild& build, ParseInfo& info)
+{
+   //Return pointer to value, to be changed.
+   return generate_var_address(scope, info, varName);
+}
+
+llvm::Value* VarExpression::GenerateRHS(ParseScope& scope, ParseBuild& build, ParseInfo& info)
+{
+   return generate_var_load(scope, build, info, varName);
+}
+
+/*
+  NB: following two should not have a value to initialise to!! 
+  The init value is assigned with an enclosing Assign expression 
+  of some kind. These just allocate things to be assigned to.
+*/
+
+llvm::Value* InitVarExpression::Generate(ParseScope& scope, ParseBuild& build, ParseInfo& info)
+{
+   //These are for inline declarations of variables.
+   return generate_init_var(scope, build, info, varName, typName);
+}
+
+llvm::Value* InitVarExpression::GenerateLHS(ParseScope& scope, ParseBuild& build, ParseInfo& info)
+{
+   return Generate(scope, build, info);
+}
+
+llvm::Value* CallExpression::Generate(ParseScope& scope, ParseBuild& build, ParseInfo& info)
+{
+   llvm::Function* called = generate_callee(build, name, args.size());
+
+   if (!called)
+      return nullptr;
+
+   vector<llvm::Value*> argValues;
+
+   for (unsigned int i = 0; i < args.size(); ++i)
+   {
+      argValues.push_back(args[i]->Generate(scope, build, info));
+
+      //Check each as you go along
+      if (!argValues.back())
+      {
+	 Log::log_error(Error(0, 0,
+			      string("Failure generating argument to function call."))); //TODO more informative
+	 
+	 return nullptr; //TODO log - but then, shouldn't the above Generate()?
+      }
+   }
+
+   return generate_call(build, info, called, argValues, name);
+}
+
+llvm::Value* BinaryExpression::Generate(ParseScope& scope, ParseBuild& build, ParseInfo& info)
+{
+   llvm::Value* left = lhs->Generate(scope, build, info);
+   llvm::Value* right = rhs->Generate(scope, build, info);
+
+   return generate_binary(build, op, left, right);
+}
+
+llvm::Value* FunctionExpression::Generate(ParseScope& scope, ParseBuild& build, ParseInfo& info)
+{
+   //FunctionExpression::Parse() only ever makes this from a
+   //SignatureExpression
+   SignatureExpression* sig = static_cast<SignatureExpression*>(signature);
+
+   llvm::Function* func = generate_function_entry(scope, build, info,
+						  sig->GetFuncName(),
+						  sig->GetRets(),
+						  sig->GetParams());
+
+   if (!func)
+      return nullptr;
+
+   //Actual generation of the statements
+   //Naive implementation: just 1:1 replicate calls.
+   //You're leaving optimisations up to llvm in that case.
+
+   for (unsigned int i = 0; i < statements.size(); ++i)
+   {
+      //These Generate()s should handle scope on their own - e.g., if
+      //an expression involves a block, it will make its own IR block.
+      //NB they should go back to previous block, too.
+      //(or, make a temporary Builder with its own insert-point- but
+      //then they'd have to pass them on and back)
+
+      statements[i]->Generate(scope, build, info);
+   }
+
+   return generate_function_exit(scope, build, info, func,
+				 sig->GetFuncName(),
+				 sig->IsVoid());
+}
+
+llvm::Value* LoopExpression::Generate(ParseScope& scope, ParseBuild& build, ParseInfo& info)
+{
+   return generate_loop(scope, build,
+			[&] { return !init || init->Generate(scope, build, info); },
+			[&] { return cond->Generate(scope, build, info); },
+			[&] { return !step || step->Generate(scope, build, info); },
+			[&]
+			{
+			   for (Expression* stmt : body)
+			      stmt->Generate(scope, build, info);
+			});
+}
+
+llvm::Value* ReturnExpression::Generate(ParseScope& scope, ParseBuild& build, ParseInfo& info)
+{
+   //Check # of args and types, too
+   //But this can only be done in the context of a function...
+   //So I'll do it in FunctionExpression...?
    
-   for (auto &it : func->args())
+   //Or you could do it like the scope 'stack', and keep a
+   //record of current function's expected returns
+
+   if (rets.size())
    {
-      const string& paramName = GetParamName(i);
+      llvm::Value* vals[rets.size()];
 
-      it.setName(paramName);
+      for (unsigned int i = 0; i < rets.size(); ++i)
+      {
+	 vals[i] = rets[i]->Generate(scope, build, info);
 
-      ++i;
+	 if (!vals[i])
+	 {
+	    //TODO: more informative?
+	    Log::log_error(Error(0, 0,
+				 string("Failed to generate expression being returned.")));
+	    return nullptr;
+	 }
+      }
+
+      return generate_return(build, llvm::ArrayRef<llvm::Value*>(vals, rets.size()));
    }
 
-   return func;
+   else return generate_return(build, llvm::ArrayRef<llvm::Value*>());
+}
+
+llvm::Function* SignatureExpression::Generate(ParseScope& scope, ParseBuild& build, ParseInfo& info)
+{
+   return generate_signature(build, info, funcName, rets, params);
 }
 
-llvm::Value* AssignExpression::Generate(ParseScope& scope, ParseBuild& build, ParseInfo info)
+llvm::Value* AssignExpression::Generate(ParseScope& scope, ParseBuild& build, ParseInfo& info)
 {
    /*
      As above, this can either be a var assigned to a var, or a ref
@@ -513,30 +1428,172 @@ llvm::Value* AssignExpression::Generate(ParseScope& scope, ParseBuild& build, Pa
    llvm::Value* l = lhs->GenerateLHS(scope, build, info);
    llvm::Value* r = rhs->Generate(scope, build, info);
 
-   if (!r)
+   return generate_assign(build, l, r);
+}
+
+//FlatTree
+
+void
+FlatTree::Generate(ParseScope& scope, ParseBuild& build, ParseInfo& info,
+		   vector<llvm::Value*>& generated)
+{
+   Generate(scope, build, info, generated, 0, roots.size());
+}
+
+void
+FlatTree::Generate(ParseScope& scope, ParseBuild& build, ParseInfo& info,
+		   vector<llvm::Value*>& generated,
+		   size_t first, size_t last)
+{
+   for (size_t i = first; i < last; ++i)
+      generated.push_back(GenerateNode(roots[i], scope, build, info));
+}
+
+llvm::Value*
+FlatTree::GenerateNode(flat_id id, ParseScope& scope, ParseBuild& build, ParseInfo& info)
+{
+   //Each case generates just as the Expression's Generate() does
+   uint32_t index = index_of(id);
+
+   switch (kind_of(id))
    {
-      if (!l)
+      case kind::FUNCTION:
       {
-	 Log::log_error(Error(0, 0,
-			      string("Failure generating either side of assignment.")));
-	 return nullptr;
+	 const function& func = functions[index];
+	 const signature& sig = signatures[index_of(func.sig)];
+
+	 llvm::Function* fn = generate_function_entry(scope, build, info,
+						      sig.name,
+						      get_rets(sig),
+						      get_params(sig));
+
+	 if (!fn)
+	    return nullptr;
+
+	 for (flat_id stmt : get_kids(func.stmts))
+	    GenerateNode(stmt, scope, build, info);
+
+	 return generate_function_exit(scope, build, info, fn,
+				       sig.name,
+				       !sig.rets.count);
       }
 
-      else
+      case kind::SIGNATURE:
       {
-	 Log::log_error(Error(0, 0,
-			      string("Failure generating right-hand side of assignment.")));
-	 return nullptr;
+	 const signature& sig = signatures[index];
+
+	 return generate_signature(build, info, sig.name, get_rets(sig), get_params(sig));
+      }
+
+      case kind::RETURN:
+      {
+	 llvm::SmallVector<llvm::Value*, 4> vals;
+
+	 for (flat_id ret : get_kids(returns[index]))
+	 {
+	    vals.push_back(GenerateNode(ret, scope, build, info));
+
+	    if (!vals.back())
+	    {
+	       Log::log_error(Error(0, 0,
+				    string("Failed to generate expression being returned.")));
+	       return nullptr;
+	    }
+	 }
+
+	 return generate_return(build, vals);
+      }
+
+      case kind::ASSIGN:
+      {
+	 //lhs first, in case it's an init
+	 llvm::Value* l = GenerateLHS(get<0>(assigns[index]), scope, build, info);
+	 llvm::Value* r = GenerateNode(get<1>(assigns[index]), scope, build, info);
+
+	 return generate_assign(build, l, r);
+      }
+
+      case kind::INIT_VAR:
+	 return generate_init_var(scope, build, info, inits[index].name, inits[index].type);
+
+      case kind::VAR:
+	 return generate_var_load(scope, build, info, vars[index].name);
+
+      case kind::CALL:
+      {
+	 const call& cl = calls[index];
+	 llvm::ArrayRef<flat_id> args = get_kids(cl.args);
+
+	 llvm::Function* called = generate_callee(build, cl.name, args.size());
+
+	 if (!called)
+	    return nullptr;
+
+	 llvm::SmallVector<llvm::Value*, 8> argValues;
+
+	 for (flat_id arg : args)
+	 {
+	    argValues.push_back(GenerateNode(arg, scope, build, info));
+
+	    if (!argValues.back())
+	    {
+	       Log::log_error(Error(0, 0,
+				    string("Failure generating argument to function call.")));
+	       return nullptr;
+	    }
+	 }
+
+	 return generate_call(build, info, called, argValues, cl.name);
+      }
+
+      case kind::BINARY:
+      {
+	 const binary& bin = binaries[index];
+
+	 llvm::Value* left = GenerateNode(bin.lhs, scope, build, info);
+	 llvm::Value* right = GenerateNode(bin.rhs, scope, build, info);
+
+	 return generate_binary(build, bin.op, left, right);
       }
+
+      case kind::LOOP:
+      {
+	 const loop& lp = loops[index];
+
+	 return generate_loop(scope, build,
+			      [&] { return (lp.init == none) || GenerateNode(lp.init, scope, build, info); },
+			      [&] { return GenerateNode(lp.cond, scope, build, info); },
+			      [&] { return (lp.step == none) || GenerateNode(lp.step, scope, build, info); },
+			      [&]
+			      {
+				 for (flat_id stmt : get_kids(lp.body))
+				    GenerateNode(stmt, scope, build, info);
+			      });
+      }
+
+      case kind::LIT_INT:
+	 return generate_lit_int(build, ints[index]);
+
+      case kind::LIT_FLOAT:
+	 return generate_lit_float(build, floats[index]);
    }
 
-   else if (!l)
+   return nullptr;
+}
+
+llvm::Value*
+FlatTree::GenerateLHS(flat_id id, ParseScope& scope, ParseBuild& build, ParseInfo& info)
+{
+   //Only variables have an l-value (cf Expression::GenerateLHS())
+   switch (kind_of(id))
    {
-      Log::log_error(Error(0, 0,
-			   string("Failure generating left-hand side of assignment.")));
-      return nullptr;
+      case kind::VAR:
+	 return generate_var_address(scope, info, vars[index_of(id)].name);
+
+      case kind::INIT_VAR:
+	 return GenerateNode(id, scope, build, info);
+
+      default:
+	 return nullptr;
    }
-   
-   return build.GetBuilder().CreateStore(r, //val
-					 l); //ptr
 }
@@ -1,18 +1,36 @@
 #include "lexer.hpp"
 
-token_kind token::GetKind() const
+#include "Interner.hpp"
+#include "log.hpp"
+#include "scanner.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+void token_string::push(const token& tok)
 {
-   return kind;
+   toks.push_back(tok);
 }
 
-string token::GetValue() const
+void token_string::append(const token_string& other)
 {
-   return value;
+   toks.insert(toks.end(), other.toks.begin(), other.toks.end());
 }
 
-void token_string::push(token tok)
+void token_string::intern(Interner& names)
 {
-   toks.push_back(tok);
+   for (token& tok : toks)
+   {
+      if (tok.IsNamed())
+	 tok.SetSymbol(names.intern(tok.GetValue()));
+   }
 }
 
 size_t token_string::size() const
@@ -20,211 +38,264 @@ size_t token_string::size() const
    return toks.size();
 }
 
-token token_string::operator[] (size_t index)
+const token& token_string::operator[] (size_t index) const
 {
    return toks[index];
 }
 
-const token token_string::operator[] (size_t index) const
+lexer::lexer(Interner* nms)
+   : buf (nullptr)
+   , pos (nullptr)
+   , end (nullptr)
+   , mapped (0)
+   , names (nms)
+   , counted (nullptr)
+   , lineStart (nullptr)
+   , line (1)
 {
-   return toks[index];
 }
 
-char lexer::next_char()
+lexer::~lexer()
+{
+   unmap_file();
+}
+
+bool lexer::map_file(const char* path)
 {
-   char res;
+   unmap_file();
+
+   int fd = ::open(path, O_RDONLY);
+
+   if (fd < 0)
+      return false;
+
+   struct stat st;
+
+   if (fstat(fd, &st) < 0)
+   {
+      close(fd);
+
+      return false;
+   }
+
+   //mmap() refuses empty mappings; an empty file is just no tokens
+   if (st.st_size == 0)
+   {
+      close(fd);
+
+      buf = pos = end = nullptr;
+
+      return true;
+   }
+
+   void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+   //The mapping stays valid after the descriptor is closed
+   close(fd);
+
+   if (addr == MAP_FAILED)
+      return false;
 
-   res = fl.get();
+   //Lexing is one forward pass
+   madvise(addr, st.st_size, MADV_SEQUENTIAL);
 
-   if (res != char_traits<char>::eof())
-      return res;
+   mapped = st.st_size;
+
+   buf = pos = (const char*) addr;
+   end = buf + mapped;
+
+   return true;
+}
+
+void lexer::unmap_file()
+{
+   if (mapped)
+   {
+      munmap((void*) buf, mapped);
+
+      mapped = 0;
+   }
+
+   buf = pos = end = nullptr;
+}
+
+char lexer::next_char()
+{
+   if (pos < end)
+      return *pos++;
 
    //You could do whitespace checking here, and simply return a
    //negative value that meant whitespace. That way the
    //semantics could be preserved by the caller.
 
-   //End of file
+   //End of file. Don't advance, so it stays end of file.
    else return -1;
 }
 
-void lexer::skip_line()
+void lexer::unget_char()
 {
-   char cur = fl.get();
+   --pos;
+}
+
+token lexer::make_token(token_kind kind, const char* start, size_t len)
+{
+   //Catch up on newlines between the last token and this one
+   const char* nl;
 
-   while (cur != '\n')
+   while ((nl = (const char*) memchr(counted, '\n', start - counted)))
    {
-      //Leave as eof token
-      if (cur == char_traits<char>::eof())
-      {
-	 fl.unget();
-	 break;
-      }
+      ++line;
 
-      else cur = fl.get();
+      counted = lineStart = nl + 1;
    }
-}
 
-void lexer::skip_closed_comment()
-{
-   char cur;
+   counted = start;
 
-   bool possible_close = false;
+   token tok(kind, llvm::StringRef(start, len),
+	     line, start - lineStart + 1);
 
-   while (cur = next_char(), cur != -1)
-   {
-      switch(cur)
-      {
-	 case '*':
-	 {
-	    possible_close = true;
-	    break;
-	 }
+   if (names && tok.IsNamed())
+      tok.SetSymbol(names->intern(tok.GetValue()));
 
-	 case '/':
-	 {
-	    if (possible_close)
-	    {
-	       //End of comment
-	       goto skip_done;
-	    }
-	 }
+   return tok;
+}
 
-	 default:
-	 {
-	    possible_close = false;
-	    break;
-	 }
-      }
-   }
+void lexer::skip_line()
+{
+   //Eat up to and including the newline; leave end of file as eof token
+   const char* nl = (const char*) memchr(pos, '\n', end - pos);
 
-  skip_done:
-   return;
+   pos = nl ? nl + 1 : end;
 }
 
-token_kind lexer::is_literal(const string& str)
+void lexer::skip_closed_comment()
 {
-   if ((str[0] == '\"') && (*str.end() == '\"'))
+   //Look for */. NB the * that opened the comment doesn't count,
+   //since pos is already past it.
+   const char* close = scanner::find_comment_close(pos, end);
+
+   //If unterminated, the rest of the file is comment
+   pos = (close < end) ? close + 2 : end;
+}
+
+token_kind lexer::classify(llvm::StringRef str) const
+{
+   //Keywords and primitives first: one hash, one compare
+   int slot = keyword_lookup.slots[keyword_hash(str.data(), str.size())];
+
+   if (slot != -1)
    {
-      return token_kind::LIT_STRING;
+      const size_t nKeywords = sizeof(keywords) / sizeof(keyword);
+
+      const keyword& kw = ((size_t) slot < nKeywords) ?
+	 keywords[slot] : primitives[slot - nKeywords];
+
+      if ((kw.len == str.size()) &&
+	  !memcmp(kw.name, str.data(), kw.len))
+	 return kw.kind;
    }
 
-   else
-   {
-      //TODO: Add hexadecimal?
+   //Otherwise a literal or a name, decided by the first character;
+   //every character is looked at once.
+   size_t i = 0;
 
-      //Either it's numeric, or false
-      if (str[0] == '.')
+   switch (str[0])
+   {
+      case '\"':
       {
-	 //Could only be float
-	 for (unsigned int i = 1; i < str.size() - 1; ++i)
-	 {
-	    if (!isdigit(str[i]))
-	       return token_kind::INVALID;
-	 }
+	 //TODO: escapes? (Also, lexemes end at whitespace, so strings
+	 //can't contain any yet.)
+	 if ((str.size() > 1) && (str.back() == '\"'))
+	    return token_kind::LIT_STRING;
 
-	 //Is float
-	 return token_kind::LIT_FLOAT;
+	 return token_kind::INVALID;
       }
 
-      else if (str[0] == '-')
+      //TODO: Add hexadecimal?
+      
+      case '-':
+      case '.':
+      case '0': case '1': case '2': case '3': case '4':
+      case '5': case '6': case '7': case '8': case '9':
       {
-	 //Could be int or float	    
-	 for (unsigned int i = 1; i < str.size() - 1; ++i)
+	 //Int or float; -.01020 etc. is fine too
+	 if (str[0] == '-')
+	    ++i;
+
+	 bool digits = false;
+	 bool point = false;
+
+	 for (; i < str.size(); ++i)
 	 {
-	    //NB could even be -.01020 etc.
-	    if (str[i] == '.')
-	    {
-	       for (unsigned int j = i + 1; j < str.size() - 1; ++j)
-	       {
-		  if (!isdigit(str[j]))
-		     return token_kind::INVALID;
-	       }
+	    if (isdigit(str[i]))
+	       digits = true;
 
-	       return token_kind::LIT_FLOAT;
-	    }
+	    else if ((str[i] == '.') && !point)
+	       point = true;
 
-	    else if (!isdigit(str[i]))
-	       return token_kind::INVALID;
+	    else return token_kind::INVALID;
 	 }
 
-	 return token_kind::LIT_FLOAT;
+	 if (!digits)
+	    return token_kind::INVALID;
+
+	 return point ? token_kind::LIT_FLOAT : token_kind::LIT_INT;
       }
 
-      else if (isdigit(str[0]))
+      default:
       {
-	 //Could be float or int
-	 for (unsigned int i = 1; i < str.size() - 1; ++i)
+	 /*
+	   All you have to do here is check that it's a valid
+	   -possible- name.
+
+	   Note also that the validity of the name in its place will
+	   be determined by the parser, not the lexer; better not to
+	   reject file outright, to have useful errors.
+	 */
+
+	 //First char has to be alphabetic or underscore
+	 //NB very important it can't have ' anywhere
+	 if (!isalpha(str[0]) &&
+	     (str[0] != '_'))
+	    return token_kind::INVALID;
+
+	 for (i = 1; i < str.size(); ++i)
 	 {
-	    if (str[i] == '.')
-	    {
-	       //Could only be float
-	       for (unsigned int j = i + 1; j < str.size() - 1; ++j)
-	       {
-		  if (!isdigit(str[j]))
-		     return token_kind::INVALID;
-	       }
-
-	       return token_kind::LIT_FLOAT;
-	    }
-
-	    else if (!isdigit(str[i]))
+	    if (!isalnum(str[i]) &&
+		(str[i] != '_') &&
+		(str[i] != '-'))
 	       return token_kind::INVALID;
 	 }
 
-	 return token_kind::LIT_INT;
-      }
-
-      else return token_kind::INVALID;
-   }
-}
+	 //Last character can't have a -
+	 if (str.back() == '-')
+	    return token_kind::INVALID;
 
-bool lexer::is_valid_name(const string& str)
-{
-   if (str.size() < 1)
-      return false;
-
-   //First char has to be alphabetic or underscore
-   //NB very important it can't have ' anywhere
-   if (!isalpha(str[0]) &&
-       (str[0] != '_'))
-      return false;
-      
-   for (unsigned int i = 1; i < str.size() - 1; ++i)
-   {
-      if (!isalnum(str[i]) &&
-	  (str[i] != '_') &&
-	  (str[i] != '-'))
-	 return false;
+	 return token_kind::NAME;
+      }
    }
-
-   //Last character can't have a -
-   if (*str.end() == '-')
-      return false;
-
-   return true;
 }
 
 token lexer::next_token()
 {
-   string lit;
    char cur;
 
+   //Position of cur in the buffer; stays at the end on end of file
+   const char* at;
+
    //Take care for possible comments since they can't be delimited
    //exclusively by whitespace
    bool possible_comment = false;
 
+   //next_char() doesn't (and shouldn't really) do this. Only ' ' and
+   //'\n' are skipped here; other whitespace ends an (empty) word below.
+   pos = scanner::skip_blanks(pos, end);
+
+   at = pos;
    cur = next_char();
 
-   //next_char() doesn't (and shouldn't really) do this
-   while ((cur == ' ') ||
-	  (cur == '\n')/* ||
-	  (cur == '\r') ||
-	  (cur == '\t') ||
-	  (cur == '\v') ||
-	  (cur == '\f')*/)
-   {
-      cur = next_char();
-   }
+   //The lexeme is [start, at) once the loop below stops
+   const char* start = at;
 
    //First pass, for things which are meaningful at start
    switch (cur)
@@ -233,19 +304,19 @@ token lexer::next_token()
 	 return token(token_kind::END);
 
       case ';':
-	 return token(token_kind::SEMICOLON);
+	 return make_token(token_kind::SEMICOLON, at, 1);
       case ',':
-	 return token(token_kind::COMMA);
+	 return make_token(token_kind::COMMA, at, 1);
 
       case '(':
-	 return token(token_kind::PAREN_OPEN);
+	 return make_token(token_kind::PAREN_OPEN, at, 1);
       case ')':
-	 return token(token_kind::PAREN_CLOSE);
+	 return make_token(token_kind::PAREN_CLOSE, at, 1);
 
       case '{':
-	 return token(token_kind::BRACE_OPEN);
+	 return make_token(token_kind::BRACE_OPEN, at, 1);
       case '}':
-	 return token(token_kind::BRACE_CLOSE);
+	 return make_token(token_kind::BRACE_CLOSE, at, 1);
    }
       
    while (true)
@@ -283,7 +354,7 @@ token lexer::next_token()
 	      So decrease pos, so that (/{ are added as tokens, too
 	      (this is what the first pass is for).
 	    */
-	    fl.unget();
+	    unget_char();
 
 	    goto abort_lit;
 	 }
@@ -296,7 +367,7 @@ token lexer::next_token()
 	       skip_line();
 
 	       //Get rid of / starting comment
-	       lit.pop_back();
+	       --at;
 		  
 	       goto abort_lit;
 	    }
@@ -316,19 +387,24 @@ token lexer::next_token()
 	       skip_closed_comment();
 
 	       //Get rid of / starting comment
-	       lit.pop_back();
+	       --at;
 		  
 	       goto abort_lit;
 	    }
 	 }
       }
 
-      lit += cur;
+      //Name characters can't end a word or start a comment, so skip
+      //any run of them in one go
+      pos = scanner::skip_name(pos, end);
 
+      at = pos;
       cur = next_char();
    }
 
   abort_lit:
+
+   llvm::StringRef lit(start, at - start);
       
    //Check it's empty (covering above's back)
    if (lit.size() == 0)
@@ -336,68 +412,285 @@ token lexer::next_token()
 
    //Check for obvious tokens, otherwise save as string (name - of
    //variable, or custom type)
-            
-   if (keywords.count(lit))
+   token_kind kind = classify(lit);
+
+   if (kind == token_kind::LIT_STRING)
    {
-      return token(keywords.find(lit)->second, lit);
+      //Return without enclosing quotes
+      return make_token(kind, start + 1, lit.size() - 2);
    }
 
-   if (primitives.count(lit))
+   //Makes sense to do error stuff (for INVALID) in the parser instead.
+   return make_token(kind, start, lit.size());
+}
+
+bool lexer::open(char* str)
+{
+   if (!map_file(str))
    {
-      return token(primitives.find(lit)->second, lit);
+      Log::log_error(Error(0, 0,
+			   string("Unable to open source file '") + str + "'."));
+
+      return false;
    }
 
-   if (is_literal(lit) != token_kind::INVALID)
+   open(buf, end - buf);
+
+   return true;
+}
+
+void lexer::open(const char* str, size_t len, uint32_t firstLine)
+{
+   //Don't drop a mapping if that's what's being opened
+   if (str != buf)
+      unmap_file();
+
+   buf = pos = str;
+   end = str + len;
+
+   counted = lineStart = str;
+   line = firstLine;
+}
+
+token_string lexer::lex(char* str)
+{
+   if (!open(str))
+      return token_string();
+
+   return lex(buf, end - buf);
+}
+
+token_string lexer::lex(const char* str, size_t len)
+{
+   token_string result;
+
+   open(str, len);
+
+   token tok = next_token();
+
+   while (tok.GetKind() != token_kind::END)
    {
-      if ((is_literal(lit) == token_kind::LIT_INT) ||
-	  (is_literal(lit) == token_kind::LIT_FLOAT))
-      {
-	 return token(is_literal(lit), lit);
-      }
+      result.push(tok);
+
+      tok = next_token();
+   }
+      
+   return result;
+}
+
+vector<const char*> lexer::split_points(const char* str, const char* stop,
+					size_t pieces)
+{
+   /*
+     A piece can start right after any newline that isn't inside a
+     closed comment: the sequential lexer is always between tokens
+     there, since a newline ends a word or a line comment. (Words
+     can't span whitespace, so neither can literals.)
+
+     So first find the closed comments. Like next_token(), a comment
+     starts at a / or * following a / in the same word; since a
+     word's earlier characters don't matter, it's enough to look at
+     the rest of the word after each /.
+   */
+   vector<const char*> commentStarts;
+   vector<const char*> commentEnds;
+
+   const char* p = str;
+
+   while (p < stop)
+   {
+      const char* slash = (const char*) memchr(p, '/', stop - p);
+
+      if (!slash)
+	 break;
+
+      p = slash + 1;
 
-      if (is_literal(lit) == token_kind::LIT_STRING)
+      //Rest of the word
+      while (p < stop)
       {
-	 //Return without enclosing quotes
-	 return token(token_kind::LIT_STRING, string(lit, 1, lit.size() - 2));
+	 p = scanner::skip_name(p, stop);
+
+	 if (p == stop)
+	    break;
+
+	 char cur = *p;
+
+	 if (cur == '/')
+	 {
+	    //Line comment: resume after the newline
+	    const char* nl = (const char*) memchr(p, '\n', stop - p);
+
+	    p = nl ? nl + 1 : stop;
+
+	    break;
+	 }
+
+	 else if (cur == '*')
+	 {
+	    const char* close = scanner::find_comment_close(p + 1, stop);
+
+	    commentStarts.push_back(p);
+	    commentEnds.push_back(p = ((close < stop) ? close + 2 : stop));
+
+	    break;
+	 }
+
+	 else if ((cur == ' ') || (cur == '\n') || (cur == '\r') ||
+		  (cur == '\t') || (cur == '\v') || (cur == '\f') ||
+		  (cur == ';') || (cur == ',') ||
+		  (cur == '(') || (cur == ')') ||
+		  (cur == '{') || (cur == '}'))
+	 {
+	    //End of word; the next / starts afresh
+	    break;
+	 }
+
+	 else ++p;
       }
    }
 
-   else
+   //Now newlines near evenly spaced targets, outside of comments
+   vector<const char*> splits;
+   
+   size_t len = stop - str;
+   size_t comment = 0;
+   
+   for (size_t i = 1; i < pieces; ++i)
    {
-      /*
-	All you have to do here is check that it's a valid
-	-possible- name.
-
-	Note also that the validity of the name in its place will
-	be determined by the parser, not the lexer; better not to
-	reject file outright, to have useful errors.
-      */
-      if (is_valid_name(lit))
+      p = str + len / pieces * i;
+
+      if (splits.size() && (p < splits.back()))
+	 p = splits.back();
+
+      while (p < stop)
       {
-	 return token(token_kind::NAME, lit);
+	 const char* nl = (const char*) memchr(p, '\n', stop - p);
+
+	 if (!nl)
+	 {
+	    p = stop;
+	    break;
+	 }
+
+	 //Comments are in order, and so are targets
+	 while ((comment < commentEnds.size()) && (commentEnds[comment] <= nl))
+	    ++comment;
+
+	 if ((comment < commentStarts.size()) && (commentStarts[comment] <= nl))
+	 {
+	    //Inside a comment; try after it
+	    p = commentEnds[comment];
+	    continue;
+	 }
+
+	 p = nl + 1;
+	 break;
       }
+
+      if ((p >= stop) || (splits.size() && (p == splits.back())))
+	 break;
+
+      splits.push_back(p);
    }
 
-   //Makes sense to do error stuff in the parser instead.
-   return token(token_kind::INVALID, lit);
+   return splits;
 }
 
-token_string lexer::lex(char* str)
+token_string lexer::lex_parallel(char* str, unsigned jobs)
 {
-   token_string result;
+   if (!open(str))
+      return token_string();
 
-   fl.open(str, ifstream::in);
-      
-//      buf = str;
+   return lex_parallel(buf, end - buf, jobs);
+}
 
-   token tok = next_token();
+token_string lexer::lex_parallel(const char* str, size_t len, unsigned jobs,
+				 size_t minChunk)
+{
+   //A byte that reads as -1 ends lexing early (see next_char()), which
+   //chunks can't reproduce; likewise there's no point for small inputs
+   if ((jobs < 2) || (len < 2 * minChunk) || memchr(str, 0xff, len))
+      return lex(str, len);
 
-   while (tok.GetKind() != token_kind::END)
+   open(str, len);
+
+   //A few chunks per thread, so that uneven ones balance out
+   size_t pieces = std::min<size_t>(jobs * 4, len / minChunk);
+
+   vector<const char*> bounds = split_points(str, str + len, pieces);
+
+   bounds.insert(bounds.begin(), str);
+   bounds.push_back(str + len);
+
+   size_t nChunks = bounds.size() - 1;
+
+   vector<uint32_t> firstLines(nChunks, 1);
+   vector<token_string> results(nChunks);
+
+   //Runs 'work' on each chunk, spread over the threads
+   auto run = [&] (const function<void(size_t)>& work)
    {
-      result.push(tok);
+      atomic<size_t> nextChunk(0);
 
-      tok = next_token();
+      auto worker = [&] ()
+      {
+	 for (size_t i; (i = nextChunk++) < nChunks;)
+	    work(i);
+      };
+	 
+      vector<thread> threads;
+
+      for (unsigned t = 1; t < std::min<size_t>(jobs, nChunks); ++t)
+	 threads.emplace_back(worker);
+
+      worker();
+
+      for (thread& t : threads)
+	 t.join();
+   };
+
+   //Line numbers: count each chunk's newlines, then each chunk starts
+   //after all the previous ones
+   run([&] (size_t i)
+   {
+      firstLines[i] = count(bounds[i], bounds[i + 1], '\n');
+   });
+
+   uint32_t line = 1;
+
+   for (size_t i = 0; i < nChunks; ++i)
+   {
+      uint32_t lines = firstLines[i];
+
+      firstLines[i] = line;
+      line += lines;
    }
-      
+
+   run([&] (size_t i)
+   {
+      //Doesn't own the buffer, so no unmapping; and doesn't intern,
+      //which is done afterwards, in order, so symbols come out the
+      //same as lex()'s
+      lexer chunk;
+
+      chunk.open(bounds[i], bounds[i + 1] - bounds[i], firstLines[i]);
+
+      for (token tok = chunk.next_token();
+	   tok.GetKind() != token_kind::END;
+	   tok = chunk.next_token())
+      {
+	 results[i].push(tok);
+      }
+   });
+
+   token_string result;
+
+   for (size_t i = 0; i < nChunks; ++i)
+      result.append(results[i]);
+
+   if (names)
+      result.intern(*names);
+
    return result;
 }
@@ -1,7 +1,5 @@
 #pragma once
 
-#include <fstream>
-
 #include <iostream>
 #include <cstring>
 
@@ -10,12 +8,16 @@
 #include <set>
 #include <vector>
 
+#include "llvm/ADT/StringRef.h"
+
 using namespace std;
 
 enum class token_kind
 {
    KEY_MAIN, //TODO: remove this (it's just a function NAME)
    KEY_RETURN,
+   KEY_FOR,
+   KEY_WHILE,
 
    COMMA,
    SEMICOLON,
@@ -31,6 +33,17 @@ enum class token_kind
    OP_EXP,
    OP_ROOT,
 
+   //Comparisons, which make bools (i1s)
+   OP_LT,
+   OP_GT,
+   OP_LE,
+   OP_GE,
+   OP_EQ,
+   OP_NE,
+
+   //Never lexed; folding makes multiplies by powers of 2 into these
+   OP_SHL,
+
    //Unlike semicolons, these are meaningful (scoping)
    BRACE_OPEN,
    BRACE_CLOSE,
@@ -57,48 +70,176 @@ enum class token_kind
 };
 
 
-static map<string, token_kind> keywords = {{"main", token_kind::KEY_MAIN},
-					   {"return", token_kind::KEY_RETURN},
-					   {"=", token_kind::OP_ASSIGN_VAL},
-					   {"'=", token_kind::OP_ASSIGN_REF},
-					   {"+", token_kind::OP_ADD},
-					   {"-", token_kind::OP_SUB},
-					   {"*", token_kind::OP_MUL},
-					   {"/", token_kind::OP_DIV},
-					   {"%", token_kind::OP_MOD},
-					   {"^", token_kind::OP_EXP},
-					   {"¬/", token_kind::OP_ROOT}};
-
-static map<string, token_kind> primitives = {{"void", token_kind::TYPE_VOID},
-					     {"int", token_kind::TYPE_INT},
-					     {"float", token_kind::TYPE_FLOAT},
-					     {"string", token_kind::TYPE_STRING},
-					     //TODO: These should be done programatically
-					     {"int'", token_kind::TYPE_INT_REF}};
+struct keyword
+{
+   const char* name;
+   size_t len;
+   token_kind kind;
+
+   template <size_t N>
+   constexpr keyword(const char (&nm)[N], token_kind k)
+      : name (nm)
+      , len (N - 1)
+      , kind (k)
+   {
+   }
+};
+
+constexpr keyword keywords[] = {{"main", token_kind::KEY_MAIN},
+				{"return", token_kind::KEY_RETURN},
+				{"for", token_kind::KEY_FOR},
+				{"while", token_kind::KEY_WHILE},
+				{"=", token_kind::OP_ASSIGN_VAL},
+				{"'=", token_kind::OP_ASSIGN_REF},
+				{"+", token_kind::OP_ADD},
+				{"-", token_kind::OP_SUB},
+				{"*", token_kind::OP_MUL},
+				{"/", token_kind::OP_DIV},
+				{"%", token_kind::OP_MOD},
+				{"^", token_kind::OP_EXP},
+				{"¬/", token_kind::OP_ROOT},
+				{"<", token_kind::OP_LT},
+				{">", token_kind::OP_GT},
+				{"<=", token_kind::OP_LE},
+				{">=", token_kind::OP_GE},
+				{"==", token_kind::OP_EQ},
+				{"!=", token_kind::OP_NE}};
+
+constexpr keyword primitives[] = {{"void", token_kind::TYPE_VOID},
+				  {"int", token_kind::TYPE_INT},
+				  {"float", token_kind::TYPE_FLOAT},
+				  {"string", token_kind::TYPE_STRING},
+				  //TODO: These should be done programatically
+				  {"int'", token_kind::TYPE_INT_REF}};
+
+/*
+  Perfect hash over keywords and primitives, so the lexer can
+  recognise them with one hash and one compare instead of tree
+  lookups. The table is built at compile time from the arrays above;
+  if a new entry collides, the static_assert below fails and the
+  multipliers need changing.
+*/
+
+constexpr size_t keyword_slots = 64;
+
+constexpr size_t keyword_hash(const char* str, size_t len)
+{
+   return (len * 3 +
+	   (unsigned char) str[0] +
+	   (unsigned char) str[len - 1] * 10) & (keyword_slots - 1);
+}
+
+struct keyword_table
+{
+   //Index into keywords (or, past its end, primitives); -1 if empty
+   signed char slots[keyword_slots];
+   bool collides;
+};
+
+constexpr keyword_table build_keyword_table()
+{
+   keyword_table table = {{}, false};
+
+   for (size_t i = 0; i < keyword_slots; ++i)
+      table.slots[i] = -1;
+
+   const size_t nKeywords = sizeof(keywords) / sizeof(keyword);
+   const size_t nPrimitives = sizeof(primitives) / sizeof(keyword);
+
+   for (size_t i = 0; i < nKeywords + nPrimitives; ++i)
+   {
+      const keyword& kw = (i < nKeywords) ? keywords[i] : primitives[i - nKeywords];
+
+      size_t slot = keyword_hash(kw.name, kw.len);
+
+      if (table.slots[slot] != -1)
+	 table.collides = true;
+
+      table.slots[slot] = i;
+   }
+
+   return table;
+}
+
+constexpr keyword_table keyword_lookup = build_keyword_table();
+
+static_assert(!keyword_lookup.collides,
+	      "Keyword hash collides; change the multipliers in keyword_hash().");
+
+//A name as interned by an Interner (see Interner.hpp)
+typedef uint32_t symbol;
+
+class Interner;
 
 class token
+/*
+  Kept small and trivially copyable, since tokens are passed around by
+  value. The value is a view into the lexer's source buffer, so the
+  lexer has to outlive any tokens it returns.
+*/
 {
 private:
    token_kind kind;
 
-   string value;
+   uint32_t len;
+   const char* value;
+
+   //Position of the start of the lexeme, both counted from 1
+   uint32_t line;
+   uint32_t column;
+
+   //Interned value, for tokens that are names (see IsNamed())
+   symbol sym;
 
 public:
 
    token(token_kind k)
       : kind (k)
-      , value ()
+      , len (0)
+      , value (nullptr)
+      , line (0)
+      , column (0)
+      , sym (0)
    {
    }
 
-   token(token_kind k, const string& v)
+   token(token_kind k, llvm::StringRef v,
+	 uint32_t li = 0, uint32_t col = 0)
       : kind (k)
-      , value (v)
+      , len (v.size())
+      , value (v.data())
+      , line (li)
+      , column (col)
+      , sym (0)
    {
    }
 
-   token_kind GetKind() const;
-   string GetValue() const;
+   token_kind GetKind() const { return kind; }
+   llvm::StringRef GetValue() const { return llvm::StringRef(value, len); }
+   uint32_t GetLine() const { return line; }
+   uint32_t GetColumn() const { return column; }
+   symbol GetSymbol() const { return sym; }
+   void SetSymbol(symbol s) { sym = s; }
+
+   //Whether the lexer interns this token's value: names, and the
+   //keywords and primitives that can stand where names do
+   bool IsNamed() const
+   {
+      switch (kind)
+      {
+	 case token_kind::NAME:
+	 case token_kind::KEY_MAIN:
+	 case token_kind::TYPE_VOID:
+	 case token_kind::TYPE_FLOAT:
+	 case token_kind::TYPE_INT:
+	 case token_kind::TYPE_STRING:
+	 case token_kind::TYPE_INT_REF:
+	    return true;
+
+	 default:
+	    return false;
+      }
+   }
 
    friend ostream& operator<< (ostream& stream, const token& tok)
    {
@@ -110,6 +251,10 @@ public:
 	    return stream << "KEY_MAIN";
 	 case token_kind::KEY_RETURN:
 	    return stream << "KEY_RETURN";
+	 case token_kind::KEY_FOR:
+	    return stream << "KEY_FOR";
+	 case token_kind::KEY_WHILE:
+	    return stream << "KEY_WHILE";
 
 	 case token_kind::COMMA:
 	    return stream << "COMMA";
@@ -135,6 +280,20 @@ public:
 	    return stream << "OP_EXP";
 	 case token_kind::OP_ROOT:
 	    return stream << "OP_ROOT";
+	 case token_kind::OP_LT:
+	    return stream << "OP_LT";
+	 case token_kind::OP_GT:
+	    return stream << "OP_GT";
+	 case token_kind::OP_LE:
+	    return stream << "OP_LE";
+	 case token_kind::OP_GE:
+	    return stream << "OP_GE";
+	 case token_kind::OP_EQ:
+	    return stream << "OP_EQ";
+	 case token_kind::OP_NE:
+	    return stream << "OP_NE";
+	 case token_kind::OP_SHL:
+	    return stream << "OP_SHL";
 	    
 	 case token_kind::PAREN_OPEN:
 	    return stream << "PAREN_OPEN";
@@ -183,10 +342,12 @@ private:
 
 public:
 
-   void push(token tok);
+   void push(const token& tok);
+   void append(const token_string& other);
+   //Set the symbols of named tokens
+   void intern(Interner& names);
    size_t size() const;
-   token operator[] (size_t index);
-   const token operator[] (size_t index) const;
+   const token& operator[] (size_t index) const;
 
    friend ostream& operator<< (ostream& stream, token_string& tokens)
    {
@@ -209,24 +370,82 @@ public:
 class lexer
 {
 private:
-   string buf;
-   ifstream fl;
+   /*
+     Source being lexed, scanned with pointer arithmetic. Either
+     mmap()ed from a file by lex(char*), or a buffer provided by the
+     caller (which has to outlive the lexer).
+   */
+   const char* buf;
+   const char* pos;
+   const char* end;
+
+   //Length of the mapping if buf was mapped by this lexer, else 0
+   size_t mapped;
+
+   //Where names are interned; none if null
+   Interner* names;
+
+   //Line bookkeeping, done lazily per token rather than per character:
+   //newlines are counted up to 'counted' only when a token needs its
+   //position.
+   const char* counted;
+   const char* lineStart;
+   uint32_t line;
 
    char next_char();
-   token next_token();
+   void unget_char();
    
    void skip_line();
    void skip_closed_comment();
 
-   token_kind is_literal(const string& str);
-   bool is_valid_name(const string& str);
+   bool map_file(const char* path);
+   void unmap_file();
+
+   //For lex_parallel(): places where the buffer can be split so that
+   //lexing each piece separately gives the same tokens
+   vector<const char*> split_points(const char* str, const char* stop,
+				    size_t pieces);
+
+   //Make a token for the lexeme [start, start + len)
+   token make_token(token_kind kind, const char* start, size_t len);
+
+   //Classify a whole lexeme in one pass: keyword, primitive,
+   //literal, name, or INVALID
+   token_kind classify(llvm::StringRef str) const;
 
 public:
-   lexer()
-   {
-   }
+   lexer(Interner* nms = nullptr);
+   ~lexer();
+
+   //Owns its mapping; not copyable
+   lexer(const lexer&) = delete;
+   lexer& operator= (const lexer&) = delete;
 
+   //Start lexing a file, by mapping it whole. Logs and returns false
+   //if it can't be read.
+   bool open(char* str);
+   //Start lexing a buffer owned by the caller. firstLine is the line
+   //number of its first character.
+   void open(const char* str, size_t len, uint32_t firstLine = 1);
+
+   //Next token of whatever was opened; END (repeatedly) once done
+   token next_token();
+
+   //Lex a file, or buffer, in one go
    token_string lex(char* str);
+   token_string lex(const char* str, size_t len);
+
+   /*
+     Lex a file, or buffer, split into chunks which are lexed on up to
+     'jobs' threads. The tokens are the same as lex() would give;
+     small inputs are just lexed sequentially. If the file can't be
+     opened that's logged, and no tokens come back.
+   */
+   static const size_t parallel_min_chunk = 256 * 1024;
+   
+   token_string lex_parallel(char* str, unsigned jobs);
+   token_string lex_parallel(const char* str, size_t len, unsigned jobs,
+			     size_t minChunk = parallel_min_chunk);
 };
 
 /*
@@ -42,6 +42,16 @@ private:
    {
    }
 
+   //Where this thread's errors go instead of the log, if anywhere. So
+   //threads working on parts of the input each keep their own errors,
+   //to be logged afterwards in source order.
+   static vector<Error>*& captured()
+   {
+      static thread_local vector<Error>* into = nullptr;
+
+      return into;
+   }
+
    static Log& getInstance()
    {
       static Log instance;
@@ -53,11 +63,34 @@ public:
 
    static void log_error(const Error& err)
    {
+      if (vector<Error>* into = captured())
+      {
+	 into->push_back(err);
+
+	 return;
+      }
+
       Log& instance = getInstance();
 
       instance.errors.push_back(err);
    }
 
+   //Log this thread's errors to 'into' until end_capture()
+   static void begin_capture(vector<Error>& into)
+   {
+      captured() = &into;
+   }
+
+   static void end_capture()
+   {
+      captured() = nullptr;
+   }
+
+   static size_t count()
+   {
+      return getInstance().errors.size();
+   }
+
    static void print()
    {
       Log& instance = getInstance();
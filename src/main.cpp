@@ -0,0 +1,388 @@
+#include "Parser.hpp"
+
+#include "log.hpp"
+#include "BuildCache.hpp"
+
+//for llvm::errs()
+#include "llvm/Support/raw_ostream.h"
+
+//for naming output files
+#include "llvm/Support/Path.h"
+
+#include <thread>
+
+using namespace std;
+
+//The number at 'at' in a flag such as -j4. False (logged) if there
+//isn't one there, or it's too big
+static bool
+flag_number(const string& arg, size_t at, unsigned& value)
+{
+   if (llvm::StringRef(arg).substr(at).getAsInteger(10, value))
+   {
+      Log::log_error(Error(0, 0, string("Bad number in '" + arg + "'.")));
+
+      return false;
+   }
+
+   return true;
+}
+
+int main(int argc, char** argv)
+{
+   char* path = nullptr;
+
+   //Threads to use (-j<n>)
+   unsigned jobs = 1;
+
+   //Generate from a FlatTree rather than the Expression tree
+   bool flatten = false;
+
+   //Generate and optimise on the -j threads too, into a module each,
+   //then link them. Reading back and linking the modules is done on
+   //one thread, so this is only worth it where there's more to do per
+   //function than that
+   bool parallelGen = false;
+
+   //-O<n>: run LLVM's passes for that level before printing IR. None
+   //at all if not given
+   int optLevel = -1;
+
+   //Print the size of the module before and after the passes
+   bool stats = false;
+
+   //-c/-S: write an object file/assembly (to -o <file>, or the input's
+   //name with .o/.s) rather than printing IR
+   bool object = false;
+   bool assembly = false;
+   string outPath;
+
+   //--emit-bc: write bitcode (to -o <file>, or the input's name with
+   //.bc); --emit-ll=<file>: write text IR to that file. Either rather
+   //than printing IR
+   bool bitcode = false;
+   string llPath;
+
+   //--run: JIT and run main, printing what it returns, rather than
+   //printing IR; --run=<name> to run that function instead
+   string entry;
+   //--lazy: with --run, only generate functions as they're called
+   bool lazy = false;
+
+   //--ssa: generate locals straight into registers, not allocas
+   bool ssa = false;
+
+   //--fold: fold constants in the parsed tree before generating it
+   bool fold = false;
+
+   //--fast-math: let float math be reassociated etc, not done exactly
+   bool fastMath = false;
+
+   //--vectorize-width=<n>, --unroll-count=<n>: what every loop is
+   //marked as wanting vectorised and unrolled by, rather than leaving
+   //it to LLVM
+   unsigned vectorizeWidth = 0;
+   unsigned unrollCount = 0;
+
+   //-march=<cpu> to generate code for; native for this one
+   string cpu;
+
+   //--cache=<dir>: keep objects compiled for -c and --run (but not
+   //--lazy) there, and use them instead of compiling the same again;
+   //--cache-limit=<size> for how much it may hold (1g unless given)
+   string cacheDir;
+   uint64_t cacheLimit = BuildCache::default_limit;
+
+   //Any flag that's bad is logged, and nothing done
+   bool badFlag = false;
+
+   for (int i = 1; i < argc; ++i)
+   {
+      const string arg = argv[i];
+
+      if (arg == "--flat")
+	 flatten = true;
+
+      else if (arg == "--parallel-gen")
+	 parallelGen = true;
+
+      else if (arg == "--stats")
+	 stats = true;
+
+      else if (arg == "-c")
+	 object = true;
+
+      else if (arg == "-S")
+	 assembly = true;
+
+      else if (arg == "--run")
+	 entry = "main";
+
+      else if (arg.compare(0, 6, "--run=") == 0)
+	 entry = arg.substr(6);
+
+      else if (arg == "--lazy")
+	 lazy = true;
+
+      else if (arg == "--ssa")
+	 ssa = true;
+
+      else if (arg == "--fold")
+	 fold = true;
+
+      else if (arg == "--fast-math")
+	 fastMath = true;
+
+      else if (arg.compare(0, 18, "--vectorize-width=") == 0)
+	 badFlag |= !flag_number(arg, 18, vectorizeWidth);
+
+      else if (arg.compare(0, 15, "--unroll-count=") == 0)
+	 badFlag |= !flag_number(arg, 15, unrollCount);
+
+      else if (arg == "--emit-bc")
+	 bitcode = true;
+
+      else if (arg.compare(0, 10, "--emit-ll=") == 0)
+	 llPath = arg.substr(10);
+
+      else if ((arg == "-o") && (i + 1 < argc))
+	 outPath = argv[++i];
+
+      else if (arg.compare(0, 7, "-march=") == 0)
+	 cpu = arg.substr(7);
+
+      else if (arg.compare(0, 8, "--cache=") == 0)
+	 cacheDir = arg.substr(8);
+
+      else if (arg.compare(0, 14, "--cache-limit=") == 0)
+	 badFlag |= !BuildCache::parse_limit(arg.substr(14), cacheLimit);
+
+      else if ((arg.size() == 3) && (arg.compare(0, 2, "-O") == 0) &&
+	       (arg[2] >= '0') && (arg[2] <= '3'))
+      {
+	 optLevel = arg[2] - '0';
+      }
+
+      else if (arg.compare(0, 2, "-j") == 0)
+      {
+	 //-j on its own means as many as there are cores
+	 if (arg.size() > 2)
+	    badFlag |= !flag_number(arg, 2, jobs);
+
+	 else jobs = thread::hardware_concurrency();
+
+	 if (!jobs)
+	    jobs = 1;
+      }
+
+      //Rather than taken as the source file
+      else if (arg.compare(0, 1, "-") == 0)
+      {
+	 Log::log_error(Error(0, 0, string("Unknown flag '" + arg + "'.")));
+
+	 badFlag = true;
+      }
+
+      else path = argv[i];
+   }
+
+   //Which would otherwise print the IR, as if it weren't there
+   if (lazy && entry.empty())
+   {
+      Log::log_error(Error(0, 0, string("--lazy is only for --run.")));
+
+      badFlag = true;
+   }
+
+   if (badFlag)
+   {
+      Log::print();
+
+      return 1;
+   }
+
+   if (!path)
+   {
+      return 1;
+   }
+   
+   if (outPath.empty())
+   {
+      llvm::SmallString<128> name(llvm::sys::path::filename(path));
+
+      llvm::sys::path::replace_extension(name, bitcode ? "bc" : assembly ? "s" : "o");
+
+      outPath = name.str().str();
+   }
+
+   //Only the one object for -c, or for --run, which is what is cached
+   bool cacheObject = object && !assembly;
+   bool cacheRun = !object && !assembly && !entry.empty() && !lazy;
+
+   unique_ptr<BuildCache> cache;
+
+   if (!cacheDir.empty() && (cacheObject || cacheRun))
+   {
+      cache = make_unique<BuildCache>(cacheDir);
+
+      llvm::ErrorOr<unique_ptr<llvm::MemoryBuffer>> source = llvm::MemoryBuffer::getFile(path);
+
+      cache->SetLimit(cacheLimit);
+
+      if (!source)
+      {
+	 Log::log_error(Error(0, 0, string("Couldn't read '" + string(path) + "'.")));
+
+	 Log::print();
+
+	 return 1;
+      }
+
+      //Codegen for --run is the JIT's, for this machine, whatever
+      //-march says
+      string target = ParseBuild::describe_target(cpu);
+
+      if (cacheRun)
+	 target += " jit " + ParseBuild::describe_target("native");
+
+      cache->SetKey((*source)->getBuffer(), optLevel, target,
+		    string(cacheObject ? "object" : "run " + entry) + (ssa ? " ssa" : "") + (fold ? " fold" : "") +
+		    (fastMath ? " fast-math" : "") +
+		    ((vectorizeWidth || unrollCount) ?
+		     " loops " + to_string(vectorizeWidth) + " " + to_string(unrollCount) : ""));
+
+      if (unique_ptr<llvm::MemoryBuffer> obj = cache->Find())
+      {
+	 if (cacheObject)
+	    ParseBuild::write_file(outPath, obj->getBuffer(), false);
+
+	 else ParseBuild::RunObject(std::move(obj), entry, cout);
+
+	 cache->Finish(stats, cout);
+
+	 Log::print();
+
+	 return 0;
+      }
+   }
+
+   Parser prs;
+
+   prs.SetSSA(ssa);
+   prs.SetFastMath(fastMath);
+   prs.SetLoopHints(vectorizeWidth, unrollCount);
+
+   //Names are interned as they're lexed
+   lexer lexer(&prs.GetNames());
+
+   if (jobs > 1)
+   {
+      //Lex the whole file up front, then parse its functions, both in
+      //parallel
+      token_string toks = lexer.lex_parallel(path, jobs);
+
+      //The file couldn't be opened
+      if (Log::count())
+      {
+	 Log::print();
+
+	 return 1;
+      }
+
+      prs.Parse(toks, jobs);
+   }
+
+   else
+   {
+      //Tokens are pulled from the lexer as the parser goes
+      if (!lexer.open(path))
+      {
+	 Log::print();
+
+	 return 1;
+      }
+
+      prs.Parse(lexer);
+   }
+
+   //(Nothing to fold if it didn't all parse)
+   if (fold && !Log::count())
+      prs.Fold(stats);
+
+   if (lazy && !entry.empty())
+   {
+      if (!Log::count())
+	 prs.RunLazy(entry, optLevel);
+
+      Log::print();
+
+      return 0;
+   }
+
+   //(Not an error; it's generated just the same)
+   if (flatten && !prs.Flatten())
+      llvm::errs() << "Couldn't flatten everything; generating from the tree instead.\n";
+
+   //prs.printTree();
+
+   //Codegen is at -O2 unless told otherwise, as llc's is
+   bool native = object || assembly || !cpu.empty();
+
+   //What's run is compiled by the JIT, for this machine whatever
+   //-march says, so it's optimised for that. (Targeted before it's
+   //generated, for --parallel-gen to optimise for it as it goes)
+   bool run = !object && !assembly && !entry.empty();
+
+   if (run ? !prs.SetJITTarget() :
+       (native && !prs.SetTarget(cpu, (optLevel >= 0) ? optLevel : 2)))
+   {
+      Log::print();
+
+      return 1;
+   }
+
+   //With --parallel-gen, optimised on the -j threads as well
+   if (parallelGen)
+      prs.Generate(jobs, optLevel);
+
+   else prs.Generate();
+
+   string lvl = " -O" + to_string(optLevel);
+
+   if (stats)
+      prs.PrintStats((parallelGen && (optLevel >= 0)) ? "Generated and" + lvl : "Generated");
+
+   if ((optLevel >= 0) && !parallelGen)
+      prs.Optimise(optLevel, stats);
+
+   if (object || assembly)
+   {
+      //Anything that failed to generate would leave bad IR
+      if (!Log::count())
+	 prs.Emit(outPath, assembly, cache.get());
+   }
+
+   else if (!entry.empty())
+   {
+      if (!Log::count())
+	 prs.Run(entry, cache.get());
+   }
+
+   else if (bitcode || !llPath.empty())
+   {
+      if (bitcode)
+	 prs.EmitIR(outPath, true);
+
+      if (!llPath.empty())
+	 prs.EmitIR(llPath, false);
+   }
+
+   else prs.printIR();
+
+   if (cache)
+      cache->Finish(stats, cout);
+
+   Log::print();
+
+   return 0;
+}
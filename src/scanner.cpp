@@ -0,0 +1,256 @@
+#include "scanner.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SCANNER_X86
+#endif
+
+//Scalar versions; also the tails of the vector ones
+
+static const char* skip_blanks_scalar(const char* p, const char* end)
+{
+   while ((p < end) && ((*p == ' ') || (*p == '\n')))
+      ++p;
+
+   return p;
+}
+
+static const char* find_comment_close_scalar(const char* p, const char* end)
+{
+   for (; p + 1 < end; ++p)
+   {
+      if ((p[0] == '*') && (p[1] == '/'))
+	 return p;
+   }
+
+   return end;
+}
+
+static bool is_name_char(char c)
+{
+   return ((c >= 'a') && (c <= 'z')) ||
+      ((c >= 'A') && (c <= 'Z')) ||
+      ((c >= '0') && (c <= '9')) ||
+      (c == '_');
+}
+
+static const char* skip_name_scalar(const char* p, const char* end)
+{
+   while ((p < end) && is_name_char(*p))
+      ++p;
+
+   return p;
+}
+
+#ifdef SCANNER_X86
+
+/*
+  The vector versions build a mask of the bytes that -do- match, so
+  the first one that doesn't is the lowest clear bit.
+
+  Signed byte compares are fine for the ranges, since all the
+  characters concerned are ASCII; bytes >= 0x80 compare as negative
+  and so never match.
+*/
+
+__attribute__((target("sse2")))
+static unsigned name_mask_sse2(__m128i c)
+{
+   //Fold case: letters become 'a'-'z'
+   __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+
+   __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+				 _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+   __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)),
+				 _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+   __m128i under = _mm_cmpeq_epi8(c, _mm_set1_epi8('_'));
+
+   return _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(alpha, digit), under));
+}
+
+__attribute__((target("sse2")))
+static const char* skip_blanks_sse2(const char* p, const char* end)
+{
+   for (; p + 16 <= end; p += 16)
+   {
+      __m128i c = _mm_loadu_si128((const __m128i*) p);
+
+      unsigned blank = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(' ')),
+						      _mm_cmpeq_epi8(c, _mm_set1_epi8('\n'))));
+
+      if (blank != 0xffff)
+	 return p + __builtin_ctz(~blank);
+   }
+
+   return skip_blanks_scalar(p, end);
+}
+
+__attribute__((target("sse2")))
+static const char* find_comment_close_sse2(const char* p, const char* end)
+{
+   //Compare each byte with '*' and its successor with '/'; hence
+   //the loads at p and p + 1.
+   for (; p + 17 <= end; p += 16)
+   {
+      __m128i star = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) p),
+				    _mm_set1_epi8('*'));
+      __m128i slash = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) (p + 1)),
+				     _mm_set1_epi8('/'));
+
+      unsigned close = _mm_movemask_epi8(_mm_and_si128(star, slash));
+
+      if (close)
+	 return p + __builtin_ctz(close);
+   }
+
+   return find_comment_close_scalar(p, end);
+}
+
+__attribute__((target("sse2")))
+static const char* skip_name_sse2(const char* p, const char* end)
+{
+   for (; p + 16 <= end; p += 16)
+   {
+      unsigned name = name_mask_sse2(_mm_loadu_si128((const __m128i*) p));
+
+      if (name != 0xffff)
+	 return p + __builtin_ctz(~name);
+   }
+
+   return skip_name_scalar(p, end);
+}
+
+__attribute__((target("avx2")))
+static unsigned name_mask_avx2(__m256i c)
+{
+   __m256i lower = _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+
+   __m256i alpha = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+				    _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+   __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('0' - 1)),
+				    _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), c));
+   __m256i under = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('_'));
+
+   return _mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(alpha, digit), under));
+}
+
+__attribute__((target("avx2")))
+static const char* skip_blanks_avx2(const char* p, const char* end)
+{
+   for (; p + 32 <= end; p += 32)
+   {
+      __m256i c = _mm256_loadu_si256((const __m256i*) p);
+
+      unsigned blank = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8(' ')),
+							    _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\n'))));
+
+      if (blank != 0xffffffff)
+	 return p + __builtin_ctz(~blank);
+   }
+
+   return skip_blanks_sse2(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char* find_comment_close_avx2(const char* p, const char* end)
+{
+   for (; p + 33 <= end; p += 32)
+   {
+      __m256i star = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) p),
+				       _mm256_set1_epi8('*'));
+      __m256i slash = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) (p + 1)),
+					_mm256_set1_epi8('/'));
+
+      unsigned close = _mm256_movemask_epi8(_mm256_and_si256(star, slash));
+
+      if (close)
+	 return p + __builtin_ctz(close);
+   }
+
+   return find_comment_close_sse2(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char* skip_name_avx2(const char* p, const char* end)
+{
+   for (; p + 32 <= end; p += 32)
+   {
+      unsigned name = name_mask_avx2(_mm256_loadu_si256((const __m256i*) p));
+
+      if (name != 0xffffffff)
+	 return p + __builtin_ctz(~name);
+   }
+
+   return skip_name_sse2(p, end);
+}
+
+#endif //SCANNER_X86
+
+bool
+scanner::supported(isa lvl)
+{
+   switch (lvl)
+   {
+      case isa::SCALAR:
+	 return true;
+
+#ifdef SCANNER_X86
+      case isa::SSE2:
+	 return __builtin_cpu_supports("sse2");
+
+      case isa::AVX2:
+	 return __builtin_cpu_supports("avx2");
+#endif
+
+      default:
+	 return false;
+   }
+}
+
+bool
+scanner::select(isa lvl)
+{
+   if (!supported(lvl))
+      return false;
+
+   switch (lvl)
+   {
+#ifdef SCANNER_X86
+      case isa::AVX2:
+	 active = {skip_blanks_avx2, find_comment_close_avx2, skip_name_avx2};
+	 break;
+
+      case isa::SSE2:
+	 active = {skip_blanks_sse2, find_comment_close_sse2, skip_name_sse2};
+	 break;
+#endif
+
+      default:
+	 active = {skip_blanks_scalar, find_comment_close_scalar, skip_name_scalar};
+	 break;
+   }
+
+   level = lvl;
+
+   return true;
+}
+
+static scanner::isa best_supported()
+{
+   if (scanner::supported(scanner::isa::AVX2))
+      return scanner::isa::AVX2;
+
+   if (scanner::supported(scanner::isa::SSE2))
+      return scanner::isa::SSE2;
+
+   return scanner::isa::SCALAR;
+}
+
+scanner::kernels scanner::active = {skip_blanks_scalar,
+				    find_comment_close_scalar,
+				    skip_name_scalar};
+
+scanner::isa scanner::level = scanner::isa::SCALAR;
+
+//Pick the best kernels before main() runs
+static bool scanner_init = scanner::select(best_supported());
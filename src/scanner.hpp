@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+
+class scanner
+/*
+  The lexer's inner loops: skipping blanks, finding the end of a
+  closed comment, and skipping runs of name characters. Each has a
+  scalar version and, on x86, SSE2 and AVX2 versions working 16 or 32
+  bytes at a time. The best the host supports is picked at startup;
+  select() overrides that (e.g. to compare them).
+
+  All of them return the first position in [p, end) that doesn't
+  match, or end. None reads outside [p, end).
+*/
+{
+public:
+   enum class isa
+   {
+      SCALAR,
+      SSE2,
+      AVX2,
+   };
+
+private:
+   struct kernels
+   {
+      const char* (*skip_blanks)(const char*, const char*);
+      const char* (*find_comment_close)(const char*, const char*);
+      const char* (*skip_name)(const char*, const char*);
+   };
+
+   static kernels active;
+   static isa level;
+
+public:
+   //Whether this build and host can run kernels of that level
+   static bool supported(isa lvl);
+   //Returns false (and changes nothing) if not supported
+   static bool select(isa lvl);
+   static isa selected() { return level; }
+
+   //Skip ' ' and '\n', as between tokens
+   static const char* skip_blanks(const char* p, const char* end)
+   { return active.skip_blanks(p, end); }
+
+   //Position of the '*' of the first "*/"
+   static const char* find_comment_close(const char* p, const char* end)
+   { return active.find_comment_close(p, end); }
+
+   //Skip [A-Za-z0-9_]
+   static const char* skip_name(const char* p, const char* end)
+   { return active.skip_name(p, end); }
+};
@@ -0,0 +1,120 @@
+#include "test.hpp"
+
+#include "../src/Parser.hpp"
+#include "../src/log.hpp"
+
+#include <sstream>
+
+using namespace std;
+
+//Compile and run src's main(), folded first or not, giving what it
+//printed; or saying so, if anything was logged
+static string
+run(const string& src, bool fold)
+{
+   size_t errors = Log::count();
+
+   Parser prs;
+   lexer lx(&prs.GetNames());
+
+   lx.open(src.data(), src.size());
+
+   prs.Parse(lx);
+
+   ostringstream out;
+
+   if (Log::count() == errors)
+   {
+      if (fold)
+	 prs.Fold(false);
+
+      prs.Generate();
+
+      streambuf* old = cout.rdbuf(out.rdbuf());
+
+      if (prs.SetJITTarget())
+	 prs.Run("main", nullptr);
+
+      cout.rdbuf(old);
+   }
+
+   if (Log::count() != errors)
+      return "(errors logged)";
+
+   //(Without the newline, to go in a check's message)
+   string printed = out.str();
+
+   if (!printed.empty() && (printed.back() == '\n'))
+      printed.pop_back();
+
+   return printed;
+}
+
+/*
+  ^ and ¬/ of ints are worked out in three places: by --fold, on
+  literals (int_pow() and int_root() in ParseFold.cpp); by codegen,
+  where the exponent or index is a constant; and at run time by
+  adze.ipow and adze.iroot, where neither is. These are the edge cases
+  (negative exponents, even roots of negatives, INT_MIN, overflow),
+  each done all three ways, which have to agree.
+*/
+static test powers("fold-powers", []
+{
+   //(No unary -, so negatives are 0 - n)
+   const string intMin = "(0 - 2147483647 - 1)";
+
+   const pair<string, string> pows[] = {{"2", "10"},
+					 {"2", "31"},
+					 {"2", "32"},
+					 {"3", "40"},
+					 {"7", "0"},
+					 {"0", "0"},
+					 {"0", "(0 - 1)"},
+					 {"1", "(0 - 5)"},
+					 {"(0 - 1)", "(0 - 3)"},
+					 {"(0 - 1)", "(0 - 4)"},
+					 {"2", "(0 - 1)"},
+					 {"(0 - 2)", "3"},
+					 {"(0 - 2)", "31"},
+					 {intMin, "2"},
+					 {intMin, "(0 - 1)"}};
+
+   //Index first: n ¬/ x is the nth root of x
+   const pair<string, string> roots[] = {{"2", "16"},
+					  {"2", "15"},
+					  {"2", "0"},
+					  {"2", "(0 - 4)"},
+					  {"2", "2147483647"},
+					  {"3", "27"},
+					  {"3", "(0 - 27)"},
+					  {"3", intMin},
+					  {"4", "2147483647"},
+					  {"31", intMin},
+					  {"1", "7"},
+					  {"5", "1"},
+					  {"0", "5"},
+					  {"(0 - 1)", "8"}};
+
+   auto agree = [](const string& l, const char* op, const string& r)
+   {
+      string expr = l + " " + op + " " + r;
+
+      string literal = "int main()\n{\n\treturn " + expr + ";\n}\n";
+
+      string called = "int f(int a, int b)\n{\n\treturn a " + string(op) + " b;\n}\n\n"
+	 "int main()\n{\n\treturn f(" + l + ", " + r + ");\n}\n";
+
+      string folded = run(literal, true);
+      string constant = run(literal, false);
+      string runTime = run(called, false);
+
+      test::check((folded == constant) && (folded == runTime) && (folded.find('(') == string::npos),
+		  expr + ": folded '" + folded + "', with constants '" + constant + "', at run time '" + runTime + "'");
+   };
+
+   for (const auto& c : pows)
+      agree(c.first, "^", c.second);
+
+   for (const auto& c : roots)
+      agree(c.first, "¬/", c.second);
+});
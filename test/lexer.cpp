@@ -0,0 +1,132 @@
+#include "test.hpp"
+
+#include "../src/lexer.hpp"
+#include "../src/Interner.hpp"
+
+#include <random>
+
+using namespace std;
+
+//Whether a and b are token for token the same: kind, where in the
+//source, line, column and symbol. If not, why goes in 'why'
+static bool
+same_tokens(const token_string& a, const token_string& b, string& why)
+{
+   if (a.size() != b.size())
+   {
+      why = to_string(a.size()) + " tokens against " + to_string(b.size());
+
+      return false;
+   }
+
+   for (size_t i = 0; i < a.size(); ++i)
+   {
+      if ((a[i].GetKind() != b[i].GetKind()) ||
+	  (a[i].GetValue().data() != b[i].GetValue().data()) ||
+	  (a[i].GetValue().size() != b[i].GetValue().size()) ||
+	  (a[i].GetLine() != b[i].GetLine()) ||
+	  (a[i].GetColumn() != b[i].GetColumn()) ||
+	  (a[i].GetSymbol() != b[i].GetSymbol()))
+      {
+	 why = "token " + to_string(i) + " ('" + a[i].GetValue().str() + "' at " +
+	    to_string(a[i].GetLine()) + ", " + to_string(a[i].GetColumn()) + ") differs";
+
+	 return false;
+      }
+   }
+
+   return true;
+}
+
+//Lex src in one go, and in parallel in chunks of at least minChunk,
+//checking that they come out the same
+static bool
+check_parallel(const string& what, const string& src, unsigned jobs, size_t minChunk)
+{
+   Interner names;
+   Interner parallelNames;
+
+   lexer lx(&names);
+   lexer parallel(&parallelNames);
+
+   token_string whole = lx.lex(src.data(), src.size());
+   token_string chunked = parallel.lex_parallel(src.data(), src.size(), jobs, minChunk);
+
+   string why;
+   bool same = same_tokens(whole, chunked, why);
+
+   return test::check(same, what + ", -j" + to_string(jobs) + ", chunks of " +
+		      to_string(minChunk) + ": " + why);
+}
+
+//Files that are mostly block comments, with what looks like code in
+//them, so that where the chunks would be split (evenly, by size) falls
+//inside a comment
+static test comments("lex-parallel-comments", []
+{
+   string src = "int f(int a)\n{\n\treturn a + 1; // not a /* start\n}\n\n/*\n";
+
+   for (int i = 0; i < 200; ++i)
+   {
+      src += " * int g_" + to_string(i) + "(int a)\n * {\n *    return a; // and not an end */\n"
+	 " * }\n";
+
+      //(That '*/' was the end)
+      src += "/*\n";
+   }
+
+   src += "*/\nint h(int b)\n{\n\t/* a short one */ return b * 2;\n}\n";
+
+   for (unsigned jobs : {2, 3, 4, 8})
+   {
+      for (size_t chunk : {16, 64, 256, 1024})
+	 check_parallel("comments", src, jobs, chunk);
+   }
+
+   //And one long comment, with no end inside it
+   string longComment = "int f()\n{\n\treturn 0;\n}\n/*";
+
+   while (longComment.size() < 64 * 1024)
+      longComment += " int g() { return 1; } // \"\n";
+
+   longComment += "*/\nint h()\n{\n\treturn 2;\n}\n";
+
+   for (unsigned jobs : {2, 4, 8})
+      check_parallel("one long comment", longComment, jobs, 1024);
+});
+
+//Random runs of fragments, many of them pieces of comments, strings
+//and blanks, at every size of chunk down to 1
+static test fragments("lex-parallel-fragments", []
+{
+   static const char* frags[] = {" ", "\n", "\t", "/", "*", "//", "/*", "*/", "a", "bc", "12",
+				 "-", ";", "(", ")", "{", "}", ",", "int", "x/y", "\"s\"", "\n\n",
+				 "  ", "1.5", "for", "<=", "¬/"};
+
+   //The same every time
+   mt19937 rng(7);
+
+   unsigned bad = 0;
+
+   for (int iter = 0; (iter < 3000) && (bad < 3); ++iter)
+   {
+      string src;
+      size_t n = rng() % 400;
+
+      for (size_t i = 0; i < n; ++i)
+	 src += frags[rng() % (sizeof(frags) / sizeof(*frags))];
+
+      for (unsigned jobs : {2, 5, 8})
+      {
+	 for (size_t chunk : {1, 4, 16, 64})
+	 {
+	    if (!check_parallel("fragments " + to_string(iter), src, jobs, chunk))
+	    {
+	       test::check(false, "in:\n" + src);
+
+	       ++bad;
+	    }
+	 }
+      }
+   }
+});
@@ -0,0 +1,184 @@
+#include "test.hpp"
+
+#include "../src/Parser.hpp"
+#include "../src/log.hpp"
+
+#include <random>
+#include <sstream>
+
+using namespace std;
+
+//One expression of n terms (1 to 9) joined by random + - and *, and
+//what it comes to with i32 arithmetic, wrapping as generated code does
+static string
+long_expression(size_t n, int32_t& value)
+{
+   //The same every time
+   mt19937 rng(12);
+
+   string expr = "1";
+
+   uint32_t sum = 0;
+   uint32_t product = 1;
+   bool negate = false;
+
+   for (size_t i = 1; i < n; ++i)
+   {
+      uint32_t term = 1 + rng() % 9;
+      unsigned op = rng() % 3;
+
+      if (op == 2)
+      {
+	 expr += " * " + to_string(term);
+	 product *= term;
+
+	 continue;
+      }
+
+      sum += negate ? -product : product;
+
+      expr += op ? " - " : " + ";
+      expr += to_string(term);
+
+      product = term;
+      negate = (op == 1);
+   }
+
+   sum += negate ? -product : product;
+
+   value = (int32_t) sum;
+
+   return expr;
+}
+
+//Compile and run src's main(), giving what it printed; and whether
+//anything was logged
+static string
+run(const string& src, bool& logged)
+{
+   size_t errors = Log::count();
+
+   Parser prs;
+   lexer lx(&prs.GetNames());
+
+   lx.open(src.data(), src.size());
+
+   prs.Parse(lx);
+
+   ostringstream out;
+
+   if (Log::count() == errors)
+   {
+      prs.Generate();
+
+      streambuf* old = cout.rdbuf(out.rdbuf());
+
+      if (prs.SetJITTarget())
+	 prs.Run("main", nullptr);
+
+      cout.rdbuf(old);
+   }
+
+   logged = (Log::count() != errors);
+
+   return out.str();
+}
+
+//A statement of 100k terms, which the recursive parser ran out of
+//stack on, compiled and run; and one of a million, just parsed
+static test longExpression("long-expression", []
+{
+   int32_t value;
+   string expr = long_expression(100000, value);
+
+   bool logged;
+   string printed = run("int main()\n{\n\treturn " + expr + ";\n}\n", logged);
+
+   test::check(!logged, "100k terms: errors logged");
+   test::check(printed == to_string(value) + "\n",
+	       "100k terms: printed '" + printed + "', not " + to_string(value));
+
+   expr = long_expression(1000000, value);
+
+   string src = "int main()\n{\n\treturn " + expr + ";\n}\n";
+   size_t errors = Log::count();
+
+   Parser prs;
+   lexer lx(&prs.GetNames());
+
+   lx.open(src.data(), src.size());
+
+   prs.Parse(lx);
+
+   test::check(Log::count() == errors, "1M terms: errors logged parsing it");
+});
+
+//Parenthesised operands, alone and mixed in with ops of each
+//precedence, and what each comes to
+static test parentheses("parentheses", []
+{
+   const pair<const char*, int> cases[] = {{"(2)", 2},
+					    {"((2))", 2},
+					    {"1 + (2 + 3)", 6},
+					    {"(2 ^ 3)", 8},
+					    {"(1 + 2) * 3", 9},
+					    {"1 + 2 * 3", 7},
+					    {"2 * (3 - 5) * 4", -16},
+					    {"10 - (4 - 3)", 9},
+					    {"10 - 4 - 3", 3},
+					    {"((1 + 2) * (3 + 4)) - 1", 20},
+					    {"2 ^ 3 ^ 2", 512},
+					    {"(2 ^ 3) ^ 2", 64},
+					    {"100 / (2 * 5) % 3", 1}};
+
+   for (const auto& c : cases)
+   {
+      bool logged;
+      string printed = run(string("int main()\n{\n\treturn ") + c.first + ";\n}\n", logged);
+
+      test::check(!logged, string(c.first) + ": errors logged");
+      test::check(printed == to_string(c.second) + "\n",
+		  string(c.first) + ": printed '" + printed + "', not " + to_string(c.second));
+   }
+});
+
+//Loops that should be rejected as they're parsed, not left to fail
+//verifying (a control statement as a for's start, or a statement
+//after a return in the body), and some that should run
+static test loops("loops", []
+{
+   const char* bad[] = {"int j = 0;\n\tfor while j < 1 { j = j + 1; } j < 3; j = j + 1 { }\n\treturn j;",
+			"int j = 0;\n\tfor return 4; 1 < 2; j = 1 { }\n\treturn j;",
+			"int n = 0;\n\tfor int i = 0; i < 5; i = i + 1 { return i; n = 3; }\n\treturn n;",
+			"int n = 0;\n\twhile n < 5 { n = n + 1; return n; n = 3; }\n\treturn n;"};
+
+   for (const char* body : bad)
+   {
+      string src = string("int main()\n{\n\t") + body + "\n}\n";
+      size_t errors = Log::count();
+
+      Parser prs;
+      lexer lx(&prs.GetNames());
+
+      lx.open(src.data(), src.size());
+
+      prs.Parse(lx);
+
+      test::check(Log::count() != errors, string("no errors logged parsing:\n\t") + body);
+   }
+
+   const pair<const char*, int> good[] = {{"int n = 0;\n\tfor int i = 0; i < 5; i = i + 1 { n = n + i; }\n\treturn n;", 10},
+					   {"int n = 0;\n\tfor n = 2; n < 7; n = n * 2 { }\n\treturn n;", 8},
+					   {"int n = 0;\n\twhile n < 7 { n = n + 2; }\n\treturn n;", 8},
+					   {"for int i = 0; i < 5; i = i + 1 { return i + 7; }\n\treturn 0;", 7}};
+
+   for (const auto& c : good)
+   {
+      bool logged;
+      string printed = run(string("int main()\n{\n\t") + c.first + "\n}\n", logged);
+
+      test::check(!logged, string("errors logged for:\n\t") + c.first);
+      test::check(printed == to_string(c.second) + "\n",
+		  string("printed '") + printed + "', not " + to_string(c.second) + ", for:\n\t" + c.first);
+   }
+});
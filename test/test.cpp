@@ -0,0 +1,83 @@
+#include "test.hpp"
+
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+unsigned test::failed = 0;
+
+vector<test*>&
+test::all()
+{
+   static vector<test*> tests;
+
+   return tests;
+}
+
+test::test(const char* nm, function<void()> fn)
+   : name (nm)
+   , run (fn)
+{
+   all().push_back(this);
+}
+
+int
+test::main(int argc, char** argv)
+{
+   vector<test*> chosen;
+
+   for (int i = 1; i < argc; ++i)
+   {
+      test* found = nullptr;
+
+      for (test* t : all())
+      {
+	 if (strcmp(t->name, argv[i]) == 0)
+	    found = t;
+      }
+
+      if (!found)
+      {
+	 cerr << "No test '" << argv[i] << "'." << endl;
+
+	 return 1;
+      }
+
+      chosen.push_back(found);
+   }
+
+   if (chosen.empty())
+      chosen = all();
+
+   for (test* t : chosen)
+   {
+      unsigned before = failed;
+
+      t->run();
+
+      cout << ((failed == before) ? "ok     " : "FAILED ") << t->name << endl;
+   }
+
+   cout << failed << " checks failed." << endl;
+
+   return failed ? 1 : 0;
+}
+
+bool
+test::check(bool ok, const string& what)
+{
+   if (!ok)
+   {
+      cout << "   " << what << endl;
+
+      ++failed;
+   }
+
+   return ok;
+}
+
+int main(int argc, char** argv)
+{
+   return test::main(argc, argv);
+}
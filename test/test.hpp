@@ -0,0 +1,37 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+class test
+/*
+  A test, of something that has to keep coming out the same however
+  it's done. `make test` builds them all into adze-test and runs
+  them; `./adze-test <name>...` runs just those.
+
+  Each file here adds its own, at file scope, as bench/ does:
+
+  static test lexing("lex", [] { test::check(..., "what went wrong"); });
+
+  and checks what it has to with check(). Any check failing fails the
+  run.
+*/
+{
+private:
+   const char* name;
+   std::function<void()> run;
+
+   static std::vector<test*>& all();
+   static unsigned failed;
+
+public:
+   test(const char* nm, std::function<void()> fn);
+
+   //Run those named in argv, or all of them if none are; 1 if any
+   //check failed, or one of them isn't a test
+   static int main(int argc, char** argv);
+
+   //If not ok, print what's wrong and fail the run. Returns ok
+   static bool check(bool ok, const std::string& what);
+};